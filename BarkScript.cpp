@@ -1,32 +1,115 @@
 #include <iostream>
+#include <iterator>
+#include <fstream>
 #include <string>
 #include <memory>
+#include <cstdlib>
+#include <thread>
+#include <vector>
 #include "vendor/optionparser-1.7/optionparser.h"
-#include "token/token.h"
-#include "lexer/lexer.h"
-#include "parser/parser.h"
-#include "object/object.h"
-#include "interpreter/interpreter.h"
 #include "context/context.h"
+#include "source/source.h"
+#include "runner/runner.h"
+#include "batch/batch.h"
+#include "profiler/profiler.h"
+#include "timings/timings.h"
+#include "pool/pool.h"
 
 const std::string bsversion = "0.1.7";
 
-enum optionIndex { CLI_UNKNOWN, CLI_HELP, CLI_NODEBUG };
+struct CliArg : public option::Arg {
+    static option::ArgStatus Required(const option::Option& option, bool msg) {
+        if (option.arg != 0)
+            return option::ARG_OK;
+
+        if (msg) std::cerr << "Option '" << std::string(option.name, option.namelen) << "' requires an argument" << std::endl;
+        return option::ARG_ILLEGAL;
+    }
+
+    static option::ArgStatus Numeric(const option::Option& option, bool msg) {
+        char* end = nullptr;
+        if (option.arg != 0 && *option.arg != '\0' && std::strtol(option.arg, &end, 10) >= 0 && *end == '\0')
+            return option::ARG_OK;
+
+        if (msg) std::cerr << "Option '" << std::string(option.name, option.namelen) << "' requires a whole number" << std::endl;
+        return option::ARG_ILLEGAL;
+    }
+};
+
+void printParseCacheStats(const std::size_t& hits, const std::size_t& misses, const std::size_t& evictions, const std::size_t& entries, const std::size_t& capacity) {
+    std::cerr << "parse cache: " << hits << " hits, " << misses << " misses, " << evictions << " evictions, " << entries << "/" << capacity << " entries" << std::endl;
+}
+
+void printParseCacheStats(const Runner& runner) {
+    const ParseCache& cache = runner.parseCache;
+    printParseCacheStats(cache.hits, cache.misses, cache.evictions, cache.size(), cache.capacity);
+}
+
+void printQuickeningStats(const QuickeningStats& stats) {
+    std::cerr << "quickening: " << stats.specializations << " specializations, " << stats.hits << " hits, " << stats.misses << " misses, " << stats.generic << " generic evaluations" << std::endl;
+}
+
+// Every thread that ran anything, the batch workers have exited by the time this is printed
+void printPoolStats() {
+    for (const PoolStats& stats : poolStats(true)) {
+        if (stats.allocations == 0) continue;
+        std::cerr << "pool: " << stats.blockSize << " byte blocks: " << stats.allocations << " allocations (" << stats.reused << " reused), " << stats.frees << " frees, "
+            << stats.remoteFrees << " from other threads, " << stats.slabs << " slabs cut, " << stats.slabsReleased << " released" << std::endl;
+    }
+    std::cerr << "pool: " << poolOversizedAllocations(true) << " allocations too big for a block" << std::endl;
+}
+
+bool writeProfile(const Profiler& profiler, const std::string& path, const std::size_t& top) {
+    std::ofstream folded(path);
+    if (!folded) {
+        std::cerr << "Could not write the profile to \"" << path << "\"" << std::endl;
+        return false;
+    }
+    profiler.writeFolded(folded);
+    profiler.writeSummary(std::cerr, top);
+    return true;
+}
+
+bool writeTrace(const Timings& timings, const std::string& path) {
+    std::ofstream trace(path);
+    if (!trace) {
+        std::cerr << "Could not write the trace to \"" << path << "\"" << std::endl;
+        return false;
+    }
+    writeChromeTrace(trace, { &timings });
+    return true;
+}
+
+enum optionIndex { CLI_UNKNOWN, CLI_HELP, CLI_NODEBUG, CLI_ENGINE, CLI_ERRORFORMAT, CLI_PARSECACHE, CLI_PARSECACHESTATS, CLI_JOBS, CLI_PROFILE, CLI_PROFILETOP, CLI_TIMINGS, CLI_TRACE, CLI_NOBSC, CLI_JIT, CLI_QUICKENINGSTATS, CLI_POOLSTATS };
 const option::Descriptor usage[] =
 {
- {CLI_UNKNOWN, 0, "", "", option::Arg::None, "USAGE: example [options]\n\n"
+ {CLI_UNKNOWN, 0, "", "", option::Arg::None, "USAGE: BarkScript [options]\n"
+                                        "       BarkScript [options] run <file>...  \tRuns whole scripts, each in its own context, - reads one from stdin\n\n"
                                         "Options:" },
  {CLI_HELP, 0, "h", "help", option::Arg::None, "  -h --help  \tPrint usage and exit." },
  {CLI_NODEBUG, 0, "nd", "nodebug", option::Arg::None, "  -nd --nodebug  \tDoes not print Lexer or Parser results." },
+ {CLI_ENGINE, 0, "e", "engine", CliArg::Required, "  -e --engine=<vm|tree>  \tPicks what runs the parsed code, the bytecode VM (default) or the tree-walking Interpreter." },
+ {CLI_ERRORFORMAT, 0, "", "error-format", CliArg::Required, "  --error-format=<full|line>  \tPrints errors with a traceback and the source (default), or as one file:line:column line each." },
+ {CLI_PARSECACHE, 0, "", "parse-cache", CliArg::Numeric, "  --parse-cache=<entries>  \tHow many parsed inputs to keep so the same input is only evaluated next time (default 64, 0 turns it off). Not used with debug output." },
+ {CLI_PARSECACHESTATS, 0, "", "parse-cache-stats", option::Arg::None, "  --parse-cache-stats  \tPrints the parse cache's hits, misses and evictions to stderr before exiting." },
+ {CLI_JOBS, 0, "j", "jobs", CliArg::Numeric, "  -j --jobs=<count>  \tHow many scripts run at once, 0 uses every core (default 1). Output still comes out in the order the scripts were given." },
+ {CLI_PROFILE, 0, "", "profile", CliArg::Required, "  --profile=<file>  \tRuns on the tree-walking Interpreter and times every node and operator. Folded stacks for flamegraph tools are written to <file>, and the slowest node types, operators and source spans are printed to stderr before exiting." },
+ {CLI_PROFILETOP, 0, "", "profile-top", CliArg::Numeric, "  --profile-top=<count>  \tHow many entries of each kind --profile prints (default 10)." },
+ {CLI_TIMINGS, 0, "", "timings", option::Arg::None, "  --timings  \tPrints how long lexing and parsing each input, and optimizing, resolving, compiling and evaluating each statement took to stderr." },
+ {CLI_TRACE, 0, "", "trace", CliArg::Required, "  --trace=<file>  \tWrites the same phases to <file> as Chrome trace event JSON (for chrome://tracing or Perfetto) with token and node counts, once everything has run." },
+ {CLI_NOBSC, 0, "", "no-bsc", option::Arg::None, "  --no-bsc  \tDoes not read or write the .bsc file next to each script run, which holds it already parsed so the next run can skip the Lexer and Parser." },
+ {CLI_JIT, 0, "", "jit", option::Arg::None, "  --jit  \tRuns on the tree-walking Interpreter and turns arithmetic and comparisons on numbers into native x86-64 code first. Anything that would give Infinity, NaN or an error is still done by the Interpreter." },
+ {CLI_QUICKENINGSTATS, 0, "", "quickening-stats", option::Arg::None, "  --quickening-stats  \tPrints how many operator nodes the tree-walking Interpreter specialized to their operand types, and how many evaluations hit or missed those specializations, to stderr before exiting." },
+ {CLI_POOLSTATS, 0, "", "pool-stats", option::Arg::None, "  --pool-stats  \tPrints how many Context, SymbolTable and Object blocks each size class of the block pool handed out and got back, and how many 64 KiB slabs it cut and gave back to the OS, to stderr before exiting." },
  {0,0,0,0,0,0}
 };
 
 int main(int argc, char* argv[]) {
     argc -= (argc > 0); argv += (argc > 0); // skip program name argv[0] if present
-    option::Stats cli_stats(usage, argc, argv);
+    option::Stats cli_stats(true, usage, argc, argv);
     std::vector<option::Option> cli_options(cli_stats.options_max);
     std::vector<option::Option> cli_buffer(cli_stats.buffer_max);
-    option::Parser cli_parse(usage, argc, argv, &cli_options[0], &cli_buffer[0]);
+    option::Parser cli_parse(true, usage, argc, argv, &cli_options[0], &cli_buffer[0]);
 
     if (cli_parse.error())
         return 1;
@@ -41,55 +124,180 @@ int main(int argc, char* argv[]) {
         printDebug = false;
     }
 
+    bool useVM = true;
+    if (cli_options[CLI_ENGINE]) {
+        std::string engine = cli_options[CLI_ENGINE].arg;
+        if (engine == "tree") {
+            useVM = false;
+        } else if (engine != "vm") {
+            std::cerr << "Unknown engine \"" << engine << "\", expected \"vm\" or \"tree\"" << std::endl;
+            return 1;
+        }
+    }
+
+    bool lineErrors = false;
+    if (cli_options[CLI_ERRORFORMAT]) {
+        std::string format = cli_options[CLI_ERRORFORMAT].arg;
+        if (format == "line") {
+            lineErrors = true;
+        } else if (format != "full") {
+            std::cerr << "Unknown error format \"" << format << "\", expected \"full\" or \"line\"" << std::endl;
+            return 1;
+        }
+    }
+
+    std::size_t parseCacheSize = 64;
+    if (cli_options[CLI_PARSECACHE]) {
+        parseCacheSize = std::strtoul(cli_options[CLI_PARSECACHE].arg, nullptr, 10);
+    }
+    bool parseCacheStats = cli_options[CLI_PARSECACHESTATS];
+    bool quickeningStats = cli_options[CLI_QUICKENINGSTATS];
+    bool printPool = cli_options[CLI_POOLSTATS];
+    bool useBscFiles = !cli_options[CLI_NOBSC];
+
+    // The profile is per node, so it needs the engine that walks them
+    std::unique_ptr<Profiler> profiler = nullptr;
+    std::string profilePath;
+    std::size_t profileTop = 10;
+    if (cli_options[CLI_PROFILE]) {
+        if (cli_options[CLI_ENGINE] && useVM) {
+            std::cerr << "--profile can only be used with the tree engine" << std::endl;
+            return 1;
+        }
+        useVM = false;
+        profiler = std::make_unique<Profiler>();
+        profilePath = cli_options[CLI_PROFILE].arg;
+    }
+    if (cli_options[CLI_PROFILETOP]) {
+        profileTop = std::strtoul(cli_options[CLI_PROFILETOP].arg, nullptr, 10);
+    }
+
+    // Native code is made from the tree, so it also needs the engine that walks it
+    bool useJit = cli_options[CLI_JIT];
+    if (useJit) {
+        if (!jitSupported()) {
+            std::cerr << "--jit is only supported on x86-64" << std::endl;
+            return 1;
+        }
+        if (cli_options[CLI_ENGINE] && useVM) {
+            std::cerr << "--jit can only be used with the tree engine" << std::endl;
+            return 1;
+        }
+        useVM = false;
+    }
+
+    bool printTimings = cli_options[CLI_TIMINGS];
+    std::string tracePath = cli_options[CLI_TRACE] ? cli_options[CLI_TRACE].arg : "";
+    std::unique_ptr<Timings> timings = nullptr;
+    if (printTimings || !tracePath.empty()) timings = std::make_unique<Timings>();
+
+    spContext context = makeSharedContext("<main>");
+    context->symbolTable = makeSharedSymbolTable();
+
+    if (cli_parse.nonOptionsCount() > 0 && std::string(cli_parse.nonOption(0)) == "run") {
+        std::vector<std::string> paths;
+        for (int i = 1; i < cli_parse.nonOptionsCount(); i++) paths.push_back(cli_parse.nonOption(i));
+        if (paths.empty()) paths.push_back("-");
+        if (paths.size() > 1 || cli_options[CLI_JOBS]) {
+            if (profiler != nullptr) {
+                std::cerr << "--profile can only be used with one script" << std::endl;
+                return 1;
+            }
+            BatchOptions options;
+            options.jobs = cli_options[CLI_JOBS] ? std::strtoul(cli_options[CLI_JOBS].arg, nullptr, 10) : 1;
+            if (options.jobs == 0) options.jobs = std::thread::hardware_concurrency();
+            options.useVM = useVM;
+            options.useJit = useJit;
+            options.lineErrors = lineErrors;
+            options.parseCacheSize = parseCacheSize;
+            options.timings = printTimings;
+            options.useBscFiles = useBscFiles;
+            std::ofstream trace;
+            if (!tracePath.empty()) {
+                trace.open(tracePath);
+                if (!trace) {
+                    std::cerr << "Could not write the trace to \"" << tracePath << "\"" << std::endl;
+                    return 1;
+                }
+                options.trace = &trace;
+            }
+            for (const std::string& path : paths) {
+                if (path == "-") {
+                    std::cerr << "- can only be run on its own" << std::endl;
+                    return 1;
+                }
+            }
+            BatchStats stats;
+            if (parseCacheStats || quickeningStats) options.stats = &stats;
+            std::ios::sync_with_stdio(false);
+            bool success = runBatch(paths, options, std::cout, std::cerr);
+            std::cout.flush();
+            if (parseCacheStats) printParseCacheStats(stats.parseCacheHits, stats.parseCacheMisses, stats.parseCacheEvictions, stats.parseCacheEntries, stats.parseCacheCapacity);
+            if (quickeningStats) printQuickeningStats(stats.quickening);
+            if (printPool) printPoolStats();
+            return success ? 0 : 1;
+        }
+        std::string path = paths[0];
+        int fileId;
+        if (path == "-") {
+            std::ios::sync_with_stdio(false);
+            std::string text((std::istreambuf_iterator<char>(std::cin)), std::istreambuf_iterator<char>());
+            fileId = registerSourceFile("<stdin>", std::move(text));
+        } else {
+            fileId = registerMappedSourceFile(path);
+            if (fileId < 0) {
+                std::cerr << "Could not open \"" << path << "\"" << std::endl;
+                return 1;
+            }
+        }
+        // No prompt and no debug output, and cout is only flushed once at the end
+        Runner runner(std::cout, context);
+        runner.printDebug = false;
+        runner.useVM = useVM;
+        runner.useJit = useJit;
+        runner.lineErrors = lineErrors;
+        runner.parseCache.capacity = parseCacheSize;
+        runner.profiler = profiler.get();
+        runner.timings = timings.get();
+        runner.useBscFiles = useBscFiles && path != "-";
+        bool success = runner.run(fileId);
+        std::cout.flush();
+        if (parseCacheStats) printParseCacheStats(runner);
+        if (quickeningStats) printQuickeningStats(runner.quickeningStats);
+        if (printPool) printPoolStats();
+        if (printTimings) timings->writeBreakdown(std::cerr);
+        if (!tracePath.empty() && !writeTrace(*timings, tracePath)) return 1;
+        if (profiler != nullptr && !writeProfile(*profiler, profilePath, profileTop)) return 1;
+        return success ? 0 : 1;
+    }
+
     std::cout << "BarkScript version " << bsversion << std::endl;
-    spContext context = std::make_shared<Context>(Context("<main>"));
-    context->symbolTable = std::make_shared<SymbolTable>(SymbolTable());
+    Runner runner(std::cout, context);
+    runner.printDebug = printDebug;
+    runner.useVM = useVM;
+    runner.useJit = useJit;
+    runner.lineErrors = lineErrors;
+    runner.parseCache.capacity = parseCacheSize;
+    runner.profiler = profiler.get();
+    runner.timings = timings.get();
     while (true) {
         //std::string input = "5+55";
         std::string input;
         std::cout << "bs > ";
         std::getline(std::cin, input);
         if (std::cin.eof()) {
+            if (parseCacheStats) printParseCacheStats(runner);
+            if (quickeningStats) printQuickeningStats(runner.quickeningStats);
+            if (printPool) printPoolStats();
+            if (profiler != nullptr && !writeProfile(*profiler, profilePath, profileTop)) return 1;
+            if (!tracePath.empty() && !writeTrace(*timings, tracePath)) return 1;
             return 0;
         }
-        Lexer lexer = Lexer(input);
-        MultiLexResult mlr = lexer.tokenize();
-        if (mlr.hasError()) {
-            std::cout << std::endl;
-            std::cout << mlr.error->to_string() << std::endl;
-            std::cout << "--------------------------" << std::endl;
-            continue;
-        }
-        if (printDebug) {
-            std::cout << std::endl;
-            for (Token token : mlr.tokenized) {
-                std::cout << token.to_string() << std::endl;
-            }
-        }
-        if (mlr.tokenized.size() != 1) {
-            Parser parser = Parser(mlr.tokenized);
-            ParseResult abSyTree = parser.parse();
-            if (abSyTree.hasError()) {
-                std::cout << std::endl;
-                std::cout << abSyTree.error->to_string() << std::endl;
-                std::cout << "--------------------------" << std::endl;
-                continue;
-            }
-            if (printDebug) {
-                std::cout << std::endl;
-                std::cout << abSyTree.node->to_string() << std::endl;
-                std::cout << std::endl;
-            }
-
-            Interpreter interpreter;
-            RuntimeResult rt = interpreter.visit(abSyTree.node, context);
-            if (rt.hasError()) {
-                std::cout << rt.error->to_string() << std::endl;
-                std::cout << "--------------------------" << std::endl;
-                continue;
-            }
-            std::cout << rt.object->to_string() << std::endl;
-        }
-        if (printDebug) std::cout << "--------------------------" << std::endl;
+        std::size_t firstEvent = timings != nullptr ? timings->events.size() : 0;
+        int fileId = registerSourceFile("<stdin>", std::move(input));
+        runner.run(fileId);
+        if (printTimings) timings->writeBreakdown(std::cerr, firstEvent);
+        // Whatever still needs the line, like the parse cache, has its own reference, so the id can be reused
+        releaseSourceFile(fileId);
     }
 }
@@ -0,0 +1,49 @@
+#include "arena.h"
+#include <cstdlib>
+#include <new>
+
+thread_local Arena* activeArena = nullptr;
+
+Arena::Arena(const std::size_t& blockSize) {
+    this->blockSize = blockSize;
+}
+
+Arena::~Arena() {
+    for (Block& block : blocks) {
+        std::free(block.data);
+    }
+}
+
+void Arena::addBlock(const std::size_t& minimumSize) {
+    std::size_t size = minimumSize > blockSize ? minimumSize : blockSize;
+    char* data = static_cast<char*>(std::malloc(size));
+    if (data == nullptr) throw std::bad_alloc();
+    blocks.push_back({ data, size });
+}
+
+void* Arena::allocate(const std::size_t& size, const std::size_t& alignment) {
+    allocations++;
+    allocatedBytes += size;
+    while (true) {
+        if (currentBlock < blocks.size()) {
+            Block& block = blocks[currentBlock];
+            std::size_t aligned = (offset + alignment - 1) & ~(alignment - 1);
+            if (aligned + size <= block.size) {
+                offset = aligned + size;
+                return block.data + aligned;
+            }
+            // Doesn't fit, move on to the next block (blocks from before a reset get reused)
+            currentBlock++;
+            offset = 0;
+            continue;
+        }
+        addBlock(size + alignment);
+    }
+}
+
+void Arena::reset() {
+    currentBlock = 0;
+    offset = 0;
+    allocatedBytes = 0;
+    allocations = 0;
+}
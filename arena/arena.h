@@ -0,0 +1,91 @@
+#pragma once
+#ifndef ARENA_H
+#define ARENA_H
+#include <cstddef>
+#include <vector>
+#include <memory>
+
+// Bump allocator for everything that only lives as long as one statement (tokens, nodes, errors)
+// Nothing is freed on its own, reset() hands all of it back at once and keeps the blocks for the next statement
+struct Arena {
+    Arena(const std::size_t& blockSize = 64 * 1024);
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(const std::size_t& size, const std::size_t& alignment = alignof(std::max_align_t));
+    void reset();
+
+    std::size_t bytesAllocated() const { return allocatedBytes; }
+    std::size_t allocationCount() const { return allocations; }
+    std::size_t blockCount() const { return blocks.size(); }
+
+private:
+    struct Block {
+        char* data;
+        std::size_t size;
+    };
+
+    std::vector<Block> blocks;
+    std::size_t blockSize;
+    std::size_t currentBlock = 0;
+    std::size_t offset = 0;
+    std::size_t allocatedBytes = 0;
+    std::size_t allocations = 0;
+
+    void addBlock(const std::size_t& minimumSize);
+};
+
+// The arena that makeSharedNode, makeSharedError and TokenList allocate from on this thread, nullptr means the normal heap
+extern thread_local Arena* activeArena;
+
+// Makes an arena the active one until the end of the scope
+struct ArenaScope {
+    Arena* previous;
+
+    ArenaScope(Arena& arena) {
+        previous = activeArena;
+        activeArena = &arena;
+    }
+
+    ~ArenaScope() {
+        activeArena = previous;
+    }
+};
+
+// Standard allocator over an Arena, falls back to the heap when it was made while no arena was active
+template<class T>
+struct ArenaAllocator {
+    typedef T value_type;
+
+    Arena* arena;
+
+    ArenaAllocator() : arena(activeArena) {}
+    ArenaAllocator(Arena* arena) : arena(arena) {}
+    template<class U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(std::size_t count) {
+        if (arena == nullptr) return std::allocator<T>().allocate(count);
+        return static_cast<T*>(arena->allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* pointer, std::size_t count) {
+        // Arena memory is only given back by Arena::reset
+        if (arena == nullptr) std::allocator<T>().deallocate(pointer, count);
+    }
+
+    template<class U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+    template<class U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+};
+
+// make_shared that uses the active arena when there is one
+template<class T, class... Args>
+std::shared_ptr<T> makeArenaShared(Args&&... args) {
+    return std::allocate_shared<T>(ArenaAllocator<T>(activeArena), std::forward<Args>(args)...);
+}
+
+#endif // !ARENA_H
@@ -3,14 +3,19 @@
 #define AST_H
 #include <string>
 #include <memory>
+#include <vector>
 #include "../token/token.h"
 #include "../position/position.h"
 #include "../symboltable/symboltable.h"
+#include "../arena/arena.h"
+#include "../interpreter/quickening.h"
 
 namespace nodetypes {
     using namespace std;
 
+    const string Program = "PROGRAM";
     const string Number = "NUMBER";
+    const string Constant = "CONSTANT";
     const string VariableDeclaration = "VARDEC";
     const string VariableAssignment = "VARASS";
     const string VariableRetrievement = "VARRET";
@@ -19,29 +24,122 @@ namespace nodetypes {
     const string Error = "ERROR";
 };
 
+// One per nodetypes:: constant, so the passes and engines switch on it instead of comparing strings
+enum class NodeKind : uint8_t {
+    Program,
+    Number,
+    Constant,
+    VariableDeclaration,
+    VariableAssignment,
+    VariableRetrievement,
+    BinaryOperator,
+    UnaryOperator,
+    Error,
+};
+
 struct Node;
+struct JitFunction;
 
 typedef std::shared_ptr<Node> spNode;
 
 // Polymorphism without having to cast to unknown types later on
 // https://stackoverflow.com/a/42539569/12101554
 // https://ideone.com/4jdhfZ
+// Nodes come from the active Arena while a statement is being parsed
 template<class NodeType>
 spNode makeSharedNode(NodeType&& node) {
-    return std::make_shared<std::remove_reference_t<NodeType>>(std::forward<NodeType>(node));
+    return makeArenaShared<std::remove_reference_t<NodeType>>(std::forward<NodeType>(node));
 }
 
 struct Node {
     std::string nodeType;
+    NodeKind kind = NodeKind::Error;
     Token token;
     Position positionStart;
     Position positionEnd;
 
-    std::string virtual to_string() const {
-        return "Not implemented! " + nodeType;
-    };
+    // Without recursing, so any tree the Parser can make can be printed
+    std::string to_string() const {
+        // Either a node still to print or text between nodes
+        struct Piece {
+            const Node* node;
+            std::string_view text;
+        };
+        std::string output;
+        std::vector<Piece> pieces;
+        pieces.push_back({ this, std::string_view() });
+        while (!pieces.empty()) {
+            Piece piece = pieces.back();
+            pieces.pop_back();
+            const Node* node = piece.node;
+            if (node == nullptr) {
+                output += piece.text;
+                continue;
+            }
+            // Pushed backwards so they come out in order
+            switch (node->kind) {
+                case NodeKind::Program:
+                    for (unsigned int i = node->statementNodes.size(); i-- > 0; ) {
+                        pieces.push_back({ node->statementNodes[i].get(), std::string_view() });
+                        if (i > 0) pieces.push_back({ nullptr, "\n" });
+                    }
+                    break;
+                case NodeKind::Number:
+                case NodeKind::VariableRetrievement:
+                case NodeKind::Error:
+                    output += node->token.value;
+                    break;
+                case NodeKind::Constant:
+                    output += node->value.to_string();
+                    break;
+                case NodeKind::VariableDeclaration:
+                case NodeKind::VariableAssignment:
+                    pieces.push_back({ nullptr, ")" });
+                    pieces.push_back({ node->valueNode.get(), std::string_view() });
+                    pieces.push_back({ nullptr, "\", EQUAL, " });
+                    pieces.push_back({ nullptr, node->token.value });
+                    pieces.push_back({ nullptr, node->kind == NodeKind::VariableDeclaration ? "(LET, identifier:\"" : "(identifier:\"" });
+                    break;
+                case NodeKind::BinaryOperator:
+                    pieces.push_back({ nullptr, ")" });
+                    pieces.push_back({ node->rightNode.get(), std::string_view() });
+                    pieces.push_back({ nullptr, ", " });
+                    pieces.push_back({ nullptr, node->token.type });
+                    pieces.push_back({ nullptr, ", " });
+                    pieces.push_back({ node->leftNode.get(), std::string_view() });
+                    pieces.push_back({ nullptr, "(" });
+                    break;
+                case NodeKind::UnaryOperator:
+                    pieces.push_back({ nullptr, ")" });
+                    pieces.push_back({ node->rightNode.get(), std::string_view() });
+                    pieces.push_back({ nullptr, ", " });
+                    pieces.push_back({ nullptr, node->token.type });
+                    pieces.push_back({ nullptr, "(" });
+                    break;
+                default:
+                    output += "Not implemented! " + node->nodeType;
+                    break;
+            }
+        }
+        return output;
+    }
 
     Node() {}
+    Node(const Node&) = default;
+    Node(Node&&) = default;
+
+    // Frees the tree under this node without recursing, so any tree the Parser can make can be freed
+    // A child that nothing else holds and that has children of its own is taken over by this loop, so it is freed
+    // with nothing left under it, leaves and shared children are freed as usual
+    virtual ~Node() {
+        std::vector<spNode> released;
+        releaseChildren(released);
+        while (!released.empty()) {
+            spNode node = std::move(released.back());
+            released.pop_back();
+            node->releaseChildren(released);
+        }
+    }
 
     virtual operator spNode() = 0;
     // All children should have the code below
@@ -52,18 +150,81 @@ struct Node {
     spNode leftNode;
     spNode rightNode;
     spNode valueNode;
+    std::vector<spNode> statementNodes;
+    // Only set for CONSTANT nodes
+    Value value;
+    // Set by the Resolver on variable nodes, a slot of -1 means the engines look the name up instead
+    int depth = 0;
+    int slot = -1;
+    // Set by the JitCompiler on the operator nodes it made native code for, the Interpreter tries that first
+    std::shared_ptr<JitFunction> jitFunction;
+    // Only looked at on a statement, so each statement is only compiled once
+    bool jitPrepared = false;
+    // Only used on operator nodes, which the Interpreter specializes to the operand types it keeps seeing
+    Quickening quickening;
+
+private:
+    bool hasChildren() const {
+        return leftNode != nullptr || rightNode != nullptr || valueNode != nullptr || !statementNodes.empty();
+    }
+
+    void releaseChildren(std::vector<spNode>& released) {
+        for (spNode* child : { &leftNode, &rightNode, &valueNode }) {
+            if (*child != nullptr && child->use_count() == 1 && (*child)->hasChildren()) released.push_back(std::move(*child));
+        }
+        for (spNode& statement : statementNodes) {
+            if (statement.use_count() == 1 && statement->hasChildren()) released.push_back(std::move(statement));
+        }
+    }
+};
+
+struct ProgramNode : Node {
+    ProgramNode(const std::vector<spNode>& statementNodes, const Position& positionStart, const Position& positionEnd) {
+        this->nodeType = nodetypes::Program;
+        this->kind = NodeKind::Program;
+        this->statementNodes = statementNodes;
+        this->positionStart = positionStart;
+        this->positionEnd = positionEnd;
+    }
+
+    operator spNode() override {
+        return makeSharedNode(*this);
+    }
 };
 
 struct NumberNode : Node {
     NumberNode(const Token& token) {
         this->nodeType = nodetypes::Number;
+        this->kind = NodeKind::Number;
         this->token = token;
         this->positionStart = token.positionStart;
         this->positionEnd = token.positionEnd;
     }
 
-    std::string to_string() const override {
-        return token.value;
+    operator spNode() override {
+        return makeSharedNode(*this);
+    }
+};
+
+// Left behind by the Optimizer in place of a literal or of a subtree made only of literals and global constants
+// Keeps the token and span of what it replaced so errors still point at the source
+struct ConstantNode : Node {
+    ConstantNode(const spNode& replaced, const Value& value) {
+        this->nodeType = nodetypes::Constant;
+        this->kind = NodeKind::Constant;
+        this->token = replaced->token;
+        this->positionStart = replaced->positionStart;
+        this->positionEnd = replaced->positionEnd;
+        this->value = value;
+    }
+
+    ConstantNode(const Token& token, const Position& positionStart, const Position& positionEnd, const Value& value) {
+        this->nodeType = nodetypes::Constant;
+        this->kind = NodeKind::Constant;
+        this->token = token;
+        this->positionStart = positionStart;
+        this->positionEnd = positionEnd;
+        this->value = value;
     }
 
     operator spNode() override {
@@ -74,16 +235,13 @@ struct NumberNode : Node {
 struct VariableDeclarationNode : Node {
     VariableDeclarationNode(const Token& token, const spNode& valueNode) {
         this->nodeType = nodetypes::VariableDeclaration;
+        this->kind = NodeKind::VariableDeclaration;
         this->token = token;
         this->valueNode = valueNode;
         this->positionStart = token.positionStart;
         this->positionEnd = valueNode->positionEnd;
     }
 
-    std::string to_string() const override {
-        return "(LET, identifier:\"" + token.value + "\", EQUAL, " + valueNode->to_string() + ")";
-    }
-
     operator spNode() override {
         return makeSharedNode(*this);
     }
@@ -92,16 +250,13 @@ struct VariableDeclarationNode : Node {
 struct VariableAssignmentNode : Node {
     VariableAssignmentNode(const Token& token, const spNode& valueNode) {
         this->nodeType = nodetypes::VariableAssignment;
+        this->kind = NodeKind::VariableAssignment;
         this->token = token;
         this->valueNode = valueNode;
         this->positionStart = token.positionStart;
         this->positionEnd = valueNode->positionEnd;
     }
 
-    std::string to_string() const override {
-        return "(identifier:\"" + token.value + "\", EQUAL, " + valueNode->to_string() + ")";
-    }
-
     operator spNode() override {
         return makeSharedNode(*this);
     }
@@ -110,15 +265,12 @@ struct VariableAssignmentNode : Node {
 struct VariableRetrievementNode : Node {
     VariableRetrievementNode(const Token& token) {
         this->nodeType = nodetypes::VariableRetrievement;
+        this->kind = NodeKind::VariableRetrievement;
         this->token = token;
         this->positionStart = token.positionStart;
         this->positionEnd = token.positionEnd;
     }
 
-    std::string to_string() const override {
-        return token.value;
-    }
-
     operator spNode() override {
         return makeSharedNode(*this);
     }
@@ -127,6 +279,7 @@ struct VariableRetrievementNode : Node {
 struct BinaryOperatorNode : Node {
     BinaryOperatorNode(const spNode& leftNode, const Token& token, const spNode& rightNode) {
         this->nodeType = nodetypes::BinaryOperator;
+        this->kind = NodeKind::BinaryOperator;
         this->token = token;
         this->leftNode = leftNode;
         this->rightNode = rightNode;
@@ -134,10 +287,6 @@ struct BinaryOperatorNode : Node {
         this->positionEnd = rightNode->positionEnd;
     }
 
-    std::string to_string() const override {
-        return "(" + leftNode->to_string() + ", " + token.type + ", " + rightNode->to_string() + ")";
-    }
-
     operator spNode() override {
         return makeSharedNode(*this);
     }
@@ -146,16 +295,13 @@ struct BinaryOperatorNode : Node {
 struct UnaryOperatorNode : Node {
     UnaryOperatorNode(const Token& token, const spNode& rightNode) {
         this->nodeType = nodetypes::UnaryOperator;
+        this->kind = NodeKind::UnaryOperator;
         this->token = token;
         this->rightNode = rightNode;
         this->positionStart = token.positionStart;
         this->positionEnd = rightNode->positionEnd;
     }
 
-    std::string to_string() const override {
-        return "(" + token.type + ", " + rightNode->to_string() + ")";
-    }
-
     operator spNode() override {
         return makeSharedNode(*this);
     }
@@ -164,13 +310,10 @@ struct UnaryOperatorNode : Node {
 struct ErrorNode : Node {
     ErrorNode(const Token& token) {
         this->nodeType = nodetypes::Error;
+        this->kind = NodeKind::Error;
         this->token = token;
     }
 
-    std::string to_string() const override {
-        return token.value;
-    }
-
     operator spNode() override {
         return makeSharedNode(*this);
     }
@@ -0,0 +1,132 @@
+#include "batch.h"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include "../context/context.h"
+#include "../source/source.h"
+#include "../runner/runner.h"
+#include "../threadpool/threadpool.h"
+#include "../timings/timings.h"
+
+struct ScriptResult {
+    std::string output;
+    std::string timings;
+    bool opened = true;
+    bool success = false;
+    bool finished = false;
+};
+
+bool runBatch(const std::vector<std::string>& paths, const BatchOptions& options, std::ostream& out, std::ostream& err) {
+    std::vector<ScriptResult> results(paths.size());
+    std::mutex resultsMutex;
+    std::condition_variable resultFinished;
+
+    unsigned int jobs = options.jobs == 0 ? 1 : options.jobs;
+    if (jobs > paths.size()) jobs = paths.size() == 0 ? 1 : paths.size();
+
+    // One Runner per worker, reused for every script that worker runs, only the Context is new each time
+    std::vector<std::unique_ptr<std::ostringstream>> buffers;
+    std::vector<std::unique_ptr<Runner>> runners;
+    std::vector<std::unique_ptr<Timings>> timings;
+    Timings::Clock::time_point origin = Timings::Clock::now();
+    for (unsigned int i = 0; i < jobs; i++) {
+        buffers.push_back(std::make_unique<std::ostringstream>());
+        runners.push_back(std::make_unique<Runner>(*buffers[i], nullptr));
+        runners[i]->printDebug = false;
+        runners[i]->useVM = options.useVM;
+        runners[i]->useJit = options.useJit;
+        runners[i]->lineErrors = options.lineErrors;
+        runners[i]->useBscFiles = options.useBscFiles;
+        if (options.timings || options.trace != nullptr) {
+            timings.push_back(std::make_unique<Timings>(origin, i));
+            runners[i]->timings = timings[i].get();
+        }
+    }
+
+    // A cached program keeps its script mapped, so only scripts that are run again are worth caching
+    std::unordered_map<std::string, int> runs;
+    for (const std::string& path : paths) runs[path]++;
+    std::vector<bool> repeated(paths.size());
+    for (unsigned int i = 0; i < paths.size(); i++) repeated[i] = runs[paths[i]] > 1;
+
+    // Declared after the runners so its workers are joined before the runners go away
+    ThreadPool pool(jobs);
+    for (unsigned int i = 0; i < paths.size(); i++) {
+        pool.submit([&, i](const unsigned int& worker) {
+            ScriptResult result;
+            int fileId = registerMappedSourceFile(paths[i]);
+            if (fileId < 0) {
+                result.opened = false;
+            } else {
+                Runner& runner = *runners[worker];
+                runner.parseCache.capacity = repeated[i] ? options.parseCacheSize : 0;
+                runner.context = makeSharedContext("<main>");
+                runner.context->symbolTable = makeSharedSymbolTable();
+                std::size_t firstEvent = runner.timings != nullptr ? runner.timings->events.size() : 0;
+                result.success = runner.run(fileId);
+                runner.context = nullptr;
+                result.output = buffers[worker]->str();
+                buffers[worker]->str("");
+                if (options.timings) {
+                    std::ostringstream breakdown;
+                    runner.timings->writeBreakdown(breakdown, firstEvent);
+                    result.timings = breakdown.str();
+                }
+                // Unmaps the script unless it was cached to run again
+                releaseSourceFile(fileId);
+            }
+            result.finished = true;
+            {
+                std::lock_guard<std::mutex> lock(resultsMutex);
+                results[i] = std::move(result);
+            }
+            resultFinished.notify_all();
+        });
+    }
+
+    bool success = true;
+    for (unsigned int i = 0; i < paths.size(); i++) {
+        ScriptResult result;
+        {
+            std::unique_lock<std::mutex> lock(resultsMutex);
+            resultFinished.wait(lock, [&]() { return results[i].finished; });
+            result = std::move(results[i]);
+        }
+        if (!result.opened) {
+            out.flush();
+            err << "Could not open \"" << paths[i] << "\"" << std::endl;
+            success = false;
+            continue;
+        }
+        out << result.output;
+        out.flush();
+        err << result.timings;
+        if (!result.success) success = false;
+    }
+
+    if (options.stats != nullptr) {
+        pool.wait();
+        BatchStats& stats = *options.stats;
+        for (const std::unique_ptr<Runner>& runner : runners) {
+            stats.parseCacheHits += runner->parseCache.hits;
+            stats.parseCacheMisses += runner->parseCache.misses;
+            stats.parseCacheEvictions += runner->parseCache.evictions;
+            stats.parseCacheEntries += runner->parseCache.size();
+            stats.parseCacheCapacity += options.parseCacheSize;
+            stats.quickening.specializations += runner->quickeningStats.specializations;
+            stats.quickening.hits += runner->quickeningStats.hits;
+            stats.quickening.misses += runner->quickeningStats.misses;
+            stats.quickening.generic += runner->quickeningStats.generic;
+        }
+    }
+
+    if (options.trace != nullptr) {
+        pool.wait();
+        std::vector<const Timings*> traced;
+        for (const std::unique_ptr<Timings>& workerTimings : timings) traced.push_back(workerTimings.get());
+        writeChromeTrace(*options.trace, traced);
+    }
+    return success;
+}
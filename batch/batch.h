@@ -0,0 +1,44 @@
+#pragma once
+#ifndef BATCH_H
+#define BATCH_H
+#include <ostream>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include "../interpreter/quickening.h"
+
+// Every worker's counters added up once the batch is done
+struct BatchStats {
+    std::size_t parseCacheHits = 0;
+    std::size_t parseCacheMisses = 0;
+    std::size_t parseCacheEvictions = 0;
+    // Programs the workers' caches still hold, out of parseCacheCapacity between all of them
+    std::size_t parseCacheEntries = 0;
+    std::size_t parseCacheCapacity = 0;
+    QuickeningStats quickening;
+};
+
+// What every script in a batch is run with
+struct BatchOptions {
+    unsigned int jobs = 1;
+    bool useVM = true;
+    bool useJit = false;
+    bool lineErrors = false;
+    // Only used for scripts that come up more than once
+    std::size_t parseCacheSize = 64;
+    bool useBscFiles = true;
+    // Each script's timings breakdown is written to err after its output
+    bool timings = false;
+    // Every script's phases are written here as one Chrome trace once the batch is done, one thread per worker
+    std::ostream* trace = nullptr;
+    // Filled in once the batch is done
+    BatchStats* stats = nullptr;
+};
+
+// Runs every script in its own Context and SymbolTable on a pool of options.jobs worker threads
+// Each script's output is buffered and written to out in the order the paths were given, as soon as every
+// script before it has finished, so the output is the same as running them one after another
+// Returns false if any script couldn't be opened or failed
+bool runBatch(const std::vector<std::string>& paths, const BatchOptions& options, std::ostream& out, std::ostream& err);
+
+#endif // !BATCH_H
@@ -0,0 +1,421 @@
+// Micro-benchmarks for the Lexer, Parser, Compiler/VM and Interpreter
+// Everything is generated here and run in process, the results are printed as JSON with a fixed layout
+// so runs can be diffed against each other
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <memory>
+#include "../source/source.h"
+#include "../token/token.h"
+#include "../lexer/lexer.h"
+#include "../parser/parser.h"
+#include "../interpreter/interpreter.h"
+#include "../compiler/compiler.h"
+#include "../vm/vm.h"
+#include "../context/context.h"
+#include "../arena/arena.h"
+#include "../resolver/resolver.h"
+#include "../runner/runner.h"
+#include "../program/program.h"
+#include "../timings/timings.h"
+#include "../jit/jit.h"
+#include "../pool/pool.h"
+
+// Every heap allocation in the process goes through here so a statement's allocations can be counted
+unsigned long long heapAllocations = 0;
+
+void* operator new(std::size_t size) {
+    heapAllocations++;
+    void* pointer = std::malloc(size == 0 ? 1 : size);
+    if (pointer == nullptr) throw std::bad_alloc();
+    return pointer;
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+struct Workload {
+    std::string name;
+    // Run once into the context before anything is measured
+    std::string setup;
+    // The statement that gets lexed, parsed and evaluated over and over
+    std::string statement;
+};
+
+struct Measurement {
+    double seconds = 0.0;
+    unsigned long long iterations = 0;
+};
+
+double minimumSeconds = 0.2;
+
+// Runs body until it has taken at least minimumSeconds, so short and long workloads are both measured well
+template<class Body>
+Measurement measure(Body body) {
+    Measurement measurement;
+    auto start = std::chrono::steady_clock::now();
+    do {
+        body();
+        measurement.iterations++;
+        measurement.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (measurement.seconds < minimumSeconds);
+    return measurement;
+}
+
+Workload arithmeticChain(const int& terms) {
+    const char operators[] = { '+', '-', '*', '/' };
+    std::string statement = "1";
+    for (int i = 1; i < terms; i++) {
+        statement += std::string(" ") + operators[i % 4] + " " + std::to_string(i % 9 + 1);
+    }
+    return { "arithmetic_chain", "", statement };
+}
+
+Workload deepParentheses(const int& depth) {
+    std::string statement;
+    for (int i = 0; i < depth; i++) statement += "(1 + ";
+    statement += "1";
+    for (int i = 0; i < depth; i++) statement += ")";
+    return { "deep_parentheses", "", statement };
+}
+
+Workload manyVariables(const int& count) {
+    std::string setup;
+    std::string statement;
+    for (int i = 0; i < count; i++) {
+        setup += "let variable" + std::to_string(i) + " = " + std::to_string(i) + "\n";
+        if (i > 0) statement += " + ";
+        statement += "variable" + std::to_string(i);
+    }
+    return { "many_variables", setup, statement };
+}
+
+Workload powerAndFlooredDivision(const int& terms) {
+    std::string statement = "2";
+    for (int i = 1; i < terms; i++) {
+        statement += i % 2 ? " ** 1.0001" : " // 1.5";
+    }
+    return { "power_and_floored_division", "", statement };
+}
+
+spNode parseStatement(const int& fileId) {
+    Lexer lexer = Lexer(fileId);
+    MultiLexResult mlr = lexer.tokenize();
+    if (mlr.hasError()) return nullptr;
+    Parser parser = Parser(mlr.tokenized);
+    ParseResult pr = parser.parse();
+    if (pr.hasError() || pr.node->statementNodes.size() != 1) return nullptr;
+    return pr.node->statementNodes[0];
+}
+
+spContext makeContext(const Workload& workload) {
+    spContext context = makeSharedContext("<bench>");
+    context->symbolTable = makeSharedSymbolTable();
+    if (workload.setup.empty()) return context;
+    Arena arena;
+    ArenaScope arenaScope(arena);
+    Lexer lexer = Lexer(workload.setup, "<setup>");
+    MultiLexResult mlr = lexer.tokenize();
+    Parser parser = Parser(mlr.tokenized);
+    ParseResult pr = parser.parse();
+    Interpreter interpreter;
+    for (const spNode& statement : pr.node->statementNodes) {
+        interpreter.visit(statement, context);
+    }
+    return context;
+}
+
+std::string formatRate(const double& count, const Measurement& measurement) {
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "%.1f", count * measurement.iterations / measurement.seconds);
+    return buffer;
+}
+
+std::string formatAverage(const double& value) {
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "%.1f", value);
+    return buffer;
+}
+
+std::string runWorkload(const Workload& workload) {
+    int fileId = registerSourceFile("<bench:" + workload.name + ">", workload.statement);
+    Arena arena;
+    spContext context = makeContext(workload);
+
+    // Shape of the workload, and a check that it actually runs before timing it
+    size_t tokenCount;
+    long long nodeCount;
+    {
+        ArenaScope arenaScope(arena);
+        Lexer lexer = Lexer(fileId);
+        tokenCount = lexer.tokenize().tokenized.size();
+        spNode statement = parseStatement(fileId);
+        if (statement == nullptr) {
+            std::cerr << "Workload " << workload.name << " does not parse" << std::endl;
+            std::exit(1);
+        }
+        nodeCount = countNodes(statement);
+        RuntimeResult rt = Interpreter().visit(statement, context);
+        if (rt.hasError()) {
+            std::cerr << "Workload " << workload.name << " fails to run:\n" << rt.error->to_string() << std::endl;
+            std::exit(1);
+        }
+    }
+    arena.reset();
+
+    Measurement lexing = measure([&]() {
+        {
+            ArenaScope arenaScope(arena);
+            Lexer lexer = Lexer(fileId);
+            MultiLexResult mlr = lexer.tokenize();
+        }
+        arena.reset();
+    });
+
+    Measurement parsing;
+    {
+        ArenaScope arenaScope(arena);
+        Lexer lexer = Lexer(fileId);
+        MultiLexResult mlr = lexer.tokenize();
+        parsing = measure([&]() {
+            Parser parser = Parser(mlr.tokenized);
+            ParseResult pr = parser.parse();
+        });
+    }
+    arena.reset();
+
+    // Evaluation only, the tree and chunk are built once up front
+    // The Optimizer is left out since it would fold most of these workloads down to one constant
+    Measurement vmEvaluation;
+    Measurement treeEvaluation;
+    {
+        ArenaScope arenaScope(arena);
+        spNode statement = parseStatement(fileId);
+        Resolver().resolve(statement, context->symbolTable);
+        CompileResult compiled = Compiler().compile(statement);
+        VM vm;
+        vmEvaluation = measure([&]() {
+            vm.run(*compiled.chunk, context);
+        });
+        Interpreter interpreter;
+        treeEvaluation = measure([&]() {
+            interpreter.visit(statement, context);
+        });
+    }
+    arena.reset();
+
+    // One whole statement, from text to result, counting every allocation on the way
+    unsigned long long vmHeapAllocations;
+    unsigned long long treeHeapAllocations;
+    size_t arenaAllocations;
+    {
+        VM vm;
+        vm.stack.reserve(1024);
+        unsigned long long before = heapAllocations;
+        {
+            ArenaScope arenaScope(arena);
+            spNode statement = parseStatement(fileId);
+            Resolver().resolve(statement, context->symbolTable);
+            CompileResult compiled = Compiler().compile(statement);
+            vm.run(*compiled.chunk, context);
+        }
+        vmHeapAllocations = heapAllocations - before;
+        arenaAllocations = arena.allocationCount();
+        arena.reset();
+
+        before = heapAllocations;
+        {
+            ArenaScope arenaScope(arena);
+            spNode statement = parseStatement(fileId);
+            Resolver().resolve(statement, context->symbolTable);
+            Interpreter().visit(statement, context);
+        }
+        treeHeapAllocations = heapAllocations - before;
+        arena.reset();
+    }
+
+    // The whole Runner on the same input over and over, so the second one only evaluates after the first run
+    Measurement uncachedRuns;
+    Measurement cachedRuns;
+    {
+        std::ostream discard(nullptr);
+        Runner uncached(discard, context);
+        uncached.printDebug = false;
+        uncached.parseCache.capacity = 0;
+        uncachedRuns = measure([&]() {
+            uncached.run(fileId);
+        });
+        Runner cached(discard, context);
+        cached.printDebug = false;
+        cachedRuns = measure([&]() {
+            cached.run(fileId);
+        });
+    }
+
+    std::ostringstream out;
+    out << "    {\n";
+    out << "      \"name\": \"" << workload.name << "\",\n";
+    out << "      \"tokens\": " << tokenCount << ",\n";
+    out << "      \"nodes\": " << nodeCount << ",\n";
+    out << "      \"lexer\": { \"tokens_per_second\": " << formatRate(tokenCount, lexing) << " },\n";
+    out << "      \"parser\": { \"nodes_per_second\": " << formatRate(nodeCount, parsing) << " },\n";
+    out << "      \"vm\": { \"evaluations_per_second\": " << formatRate(1, vmEvaluation) << " },\n";
+    out << "      \"tree\": { \"evaluations_per_second\": " << formatRate(1, treeEvaluation) << " },\n";
+    out << "      \"runner\": { \"uncached_runs_per_second\": " << formatRate(1, uncachedRuns) << ", \"cached_runs_per_second\": " << formatRate(1, cachedRuns) << " },\n";
+    out << "      \"allocations_per_statement\": { \"vm_heap\": " << vmHeapAllocations << ", \"tree_heap\": " << treeHeapAllocations << ", \"arena\": " << arenaAllocations << " }\n";
+    out << "    }";
+    return out.str();
+}
+
+// The library API, compiling one expression and evaluating it against changing bindings
+std::string runProgramApi() {
+    const std::string source = "x * x + y / 2 - x ** 2";
+    const std::vector<std::string> bindingNames = { "x", "y" };
+    ProgramResult compiled = Program::compile(source, bindingNames, "<bench:program_api>");
+    if (compiled.hasError()) {
+        std::cerr << "Program API workload does not compile:\n" << compiled.error << std::endl;
+        std::exit(1);
+    }
+    Measurement compiling = measure([&]() {
+        Program::compile(source, bindingNames, "<bench:program_api>");
+    });
+    std::vector<Value> bindings = { Number(1.0), Number(2.0) };
+    double x = 0.0;
+    Measurement evaluating = measure([&]() {
+        bindings[0] = Number(x);
+        x += 1.0;
+        compiled.program->evaluate(bindings);
+    });
+
+    // Every evaluation makes a fresh Context and SymbolTable, so this is where the block pool shows
+    unsigned long long before = heapAllocations;
+    const int evaluations = 1000;
+    for (int i = 0; i < evaluations; i++) compiled.program->evaluate(bindings);
+    double heapPerEvaluation = (double) (heapAllocations - before) / evaluations;
+
+    std::ostringstream out;
+    out << "  \"program_api\": { \"compiles_per_second\": " << formatRate(1, compiling) << ", \"evaluations_per_second\": " << formatRate(1, evaluating)
+        << ", \"heap_allocations_per_evaluation\": " << formatAverage(heapPerEvaluation) << " }";
+    return out.str();
+}
+
+// The tree-walking Interpreter with and without native code, test/Test.cpp checks that they agree
+std::string runJit() {
+    if (!jitSupported()) return "  \"jit\": { \"supported\": false }";
+
+    Workload workload = { "jit", "let x = 3\nlet y = 4.5\nlet z = 7\n", "(x * x + y / 2 - x ** 2) * (z - y) // 3 < x + y * z - (x - 1) * (y + 1)" };
+    int fileId = registerSourceFile("<bench:" + workload.name + ">", workload.statement);
+    Arena arena;
+    spContext context = makeContext(workload);
+    Measurement interpreted;
+    Measurement native;
+    std::size_t compiledFunctions;
+    {
+        ArenaScope arenaScope(arena);
+        spNode statement = parseStatement(fileId);
+        Resolver().resolve(statement, context->symbolTable);
+        Interpreter interpreter;
+        interpreted = measure([&]() {
+            interpreter.visit(statement, context);
+        });
+        JitCompiler jitCompiler;
+        jitCompiler.prepare(statement);
+        compiledFunctions = jitCompiler.compiledFunctions;
+        native = measure([&]() {
+            interpreter.visit(statement, context);
+        });
+    }
+
+    std::ostringstream out;
+    out << "  \"jit\": { \"supported\": true, \"compiled_functions\": " << compiledFunctions << ", \"interpreted_evaluations_per_second\": " << formatRate(1, interpreted)
+        << ", \"native_evaluations_per_second\": " << formatRate(1, native) << " }";
+    return out.str();
+}
+
+// Contexts, each with its own SymbolTable under the same parent, made, run and dropped the way call frames will be,
+// test/Test.cpp checks that none of them stay alive
+std::string runContextChurn() {
+    spContext global = makeSharedContext("<bench>");
+    global->symbolTable = makeSharedSymbolTable();
+    global->symbolTable->set("x", Number(2.0), true);
+    Arena arena;
+    ArenaScope arenaScope(arena);
+    int fileId = registerSourceFile("<bench:context churn>", "x * y + 1");
+    spNode statement = parseStatement(fileId);
+
+    Interpreter interpreter;
+    double y = 0.0;
+    Measurement churning = measure([&]() {
+        spContext frame = makeSharedContext("<frame>", global.get());
+        frame->symbolTable = makeSharedSymbolTable();
+        frame->symbolTable->parent = global->symbolTable.get();
+        frame->symbolTable->set("y", Number(y), true);
+        y += 1.0;
+        interpreter.visit(statement, frame);
+    });
+
+    std::ostringstream out;
+    out << "  \"context_churn\": { \"contexts_per_second\": " << formatRate(1, churning) << " }";
+    return out.str();
+}
+
+// What the block pool did on this thread over every run above
+std::string runPoolStats() {
+    std::ostringstream out;
+    out << "  \"pool\": { \"oversized_allocations\": " << poolOversizedAllocations() << ", \"size_classes\": [";
+    std::vector<PoolStats> stats = poolStats();
+    for (std::size_t i = 0; i < stats.size(); i++) {
+        out << (i > 0 ? ", " : " ") << "{ \"block_size\": " << stats[i].blockSize << ", \"allocations\": " << stats[i].allocations << ", \"reused\": " << stats[i].reused
+            << ", \"frees\": " << stats[i].frees << ", \"remote_frees\": " << stats[i].remoteFrees << ", \"slabs\": " << stats[i].slabs << ", \"slabs_released\": " << stats[i].slabsReleased << " }";
+    }
+    out << " ] }";
+    return out.str();
+}
+
+int main(int argc, char* argv[]) {
+    // bench [seconds per measurement]
+    if (argc > 1) minimumSeconds = std::atof(argv[1]);
+
+    std::vector<Workload> workloads = {
+        arithmeticChain(2000),
+        deepParentheses(500),
+        manyVariables(1000),
+        powerAndFlooredDivision(1000),
+    };
+
+    std::cout << "{\n";
+    std::cout << "  \"minimum_seconds_per_measurement\": " << formatAverage(minimumSeconds) << ",\n";
+    std::cout << "  \"benchmarks\": [\n";
+    for (unsigned int i = 0; i < workloads.size(); i++) {
+        std::cout << runWorkload(workloads[i]) << (i + 1 < workloads.size() ? ",\n" : "\n");
+    }
+    std::cout << "  ],\n";
+    std::cout << runProgramApi() << ",\n";
+    std::cout << runJit() << ",\n";
+    std::cout << runContextChurn() << ",\n";
+    std::cout << runPoolStats() << "\n";
+    std::cout << "}" << std::endl;
+    return 0;
+}
@@ -0,0 +1,288 @@
+#include "bscfile.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <unordered_map>
+#include "../arena/arena.h"
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+    int processId() {
+#ifdef _WIN32
+        return _getpid();
+#else
+        return (int) getpid();
+#endif
+    }
+
+    const char bscMagic[4] = { 'B', 'S', 'C', '\0' };
+    const uint32_t bscByteOrder = 0x01020304;
+
+    enum class BscNodeType : uint8_t {
+        Number,
+        Constant,
+        VariableDeclaration,
+        VariableAssignment,
+        VariableRetrievement,
+        BinaryOperator,
+        UnaryOperator,
+        COUNT,
+    };
+
+    enum BscValueFlag : uint8_t {
+        Sign = 1 << 0,
+        Infinity = 1 << 1,
+        NaN = 1 << 2,
+        PureDouble = 1 << 3,
+        PureZero = 1 << 4,
+    };
+
+    bool nodeTypeOf(const NodeKind& kind, BscNodeType& type) {
+        switch (kind) {
+            case NodeKind::Number: type = BscNodeType::Number; return true;
+            case NodeKind::Constant: type = BscNodeType::Constant; return true;
+            case NodeKind::VariableDeclaration: type = BscNodeType::VariableDeclaration; return true;
+            case NodeKind::VariableAssignment: type = BscNodeType::VariableAssignment; return true;
+            case NodeKind::VariableRetrievement: type = BscNodeType::VariableRetrievement; return true;
+            case NodeKind::BinaryOperator: type = BscNodeType::BinaryOperator; return true;
+            case NodeKind::UnaryOperator: type = BscNodeType::UnaryOperator; return true;
+            default: return false;
+        }
+    }
+
+    bool readMapped(const char* bytes, const std::size_t& size, const int& fileId, std::vector<spNode>& statements) {
+        BscHeader header;
+        if (size < sizeof(header)) return false;
+        std::memcpy(&header, bytes, sizeof(header));
+        if (std::memcmp(header.magic, bscMagic, sizeof(bscMagic)) != 0 || header.version != bscFormatVersion || header.byteOrder != bscByteOrder) return false;
+
+        std::string_view text = getSourceFile(fileId).text;
+        if (header.sourceSize != text.size() || header.sourceHash != hashSource(text)) return false;
+        uint64_t expectedSize = sizeof(header) + (uint64_t) header.nodeCount * sizeof(BscNode) + (uint64_t) header.statementCount * sizeof(uint32_t) + header.stringBytes;
+        if (expectedSize != size) return false;
+
+        const char* nodeBytes = bytes + sizeof(header);
+        const char* statementBytes = nodeBytes + (std::size_t) header.nodeCount * sizeof(BscNode);
+        const char* stringBytes = statementBytes + (std::size_t) header.statementCount * sizeof(uint32_t);
+        // The mapping is gone once this returns, token values need to outlive it
+        char* strings = ArenaAllocator<char>().allocate(header.stringBytes + 1);
+        std::memcpy(strings, stringBytes, header.stringBytes);
+
+        std::vector<spNode> nodes;
+        nodes.reserve(header.nodeCount);
+        for (uint32_t i = 0; i < header.nodeCount; i++) {
+            BscNode record;
+            std::memcpy(&record, nodeBytes + (std::size_t) i * sizeof(BscNode), sizeof(record));
+            if (record.type >= (uint8_t) BscNodeType::COUNT || record.tokenKind >= (uint8_t) TokenKind::COUNT) return false;
+            if ((uint64_t) record.tokenValue + record.tokenValueSize > header.stringBytes) return false;
+            for (const int32_t& index : { record.tokenStart, record.tokenEnd, record.start, record.end }) {
+                if (index < 0 || (uint64_t) index > text.size()) return false;
+            }
+            for (const int32_t& child : { record.left, record.right, record.value }) {
+                if (child < -1 || child >= (int32_t) i) return false;
+            }
+            spNode left = record.left == -1 ? nullptr : nodes[record.left];
+            spNode right = record.right == -1 ? nullptr : nodes[record.right];
+            spNode value = record.value == -1 ? nullptr : nodes[record.value];
+
+            Token token((TokenKind) record.tokenKind, std::string_view(strings + record.tokenValue, record.tokenValueSize), Position(fileId, record.tokenStart), Position(fileId, record.tokenEnd), false);
+            Position start(fileId, record.start);
+            Position end(fileId, record.end);
+            spNode node;
+            switch ((BscNodeType) record.type) {
+                case BscNodeType::Number: { node = NumberNode(token); break; }
+                case BscNodeType::Constant:
+                {
+                    Value constant;
+                    if (record.valueType > (uint8_t) ValueType::Null) return false;
+                    constant.type = (ValueType) record.valueType;
+                    constant.sign = record.valueFlags & BscValueFlag::Sign;
+                    constant.isInfinity = record.valueFlags & BscValueFlag::Infinity;
+                    constant.isNaN = record.valueFlags & BscValueFlag::NaN;
+                    constant.isPureDouble = record.valueFlags & BscValueFlag::PureDouble;
+                    constant.isPureZero = record.valueFlags & BscValueFlag::PureZero;
+                    constant.doubleValue = record.number;
+                    node = ConstantNode(token, start, end, constant);
+                    break;
+                }
+                case BscNodeType::VariableDeclaration:
+                {
+                    if (value == nullptr) return false;
+                    node = VariableDeclarationNode(token, value);
+                    break;
+                }
+                case BscNodeType::VariableAssignment:
+                {
+                    if (value == nullptr) return false;
+                    node = VariableAssignmentNode(token, value);
+                    break;
+                }
+                case BscNodeType::VariableRetrievement: { node = VariableRetrievementNode(token); break; }
+                case BscNodeType::BinaryOperator:
+                {
+                    if (left == nullptr || right == nullptr) return false;
+                    node = BinaryOperatorNode(left, token, right);
+                    break;
+                }
+                case BscNodeType::UnaryOperator:
+                {
+                    if (right == nullptr) return false;
+                    node = UnaryOperatorNode(token, right);
+                    break;
+                }
+                default: return false;
+            }
+            node->positionStart = start;
+            node->positionEnd = end;
+            nodes.push_back(node);
+        }
+
+        std::vector<spNode> read;
+        read.reserve(header.statementCount);
+        for (uint32_t i = 0; i < header.statementCount; i++) {
+            uint32_t index;
+            std::memcpy(&index, statementBytes + (std::size_t) i * sizeof(uint32_t), sizeof(index));
+            if (index >= header.nodeCount) return false;
+            read.push_back(nodes[index]);
+        }
+        statements.insert(statements.end(), read.begin(), read.end());
+        return true;
+    }
+}
+
+std::string bscPathFor(const std::string& sourcePath) {
+    const std::string extension = ".bs";
+    if (sourcePath.size() > extension.size() && sourcePath.compare(sourcePath.size() - extension.size(), extension.size(), extension) == 0)
+        return sourcePath + "c";
+    return sourcePath + ".bsc";
+}
+
+uint64_t hashSource(const std::string_view& text) {
+    // 64 bit FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for (const char& c : text) {
+        hash ^= (unsigned char) c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool writeBscFile(const std::string& path, const SourceFile& source, const std::vector<spNode>& statements) {
+    std::vector<BscNode> nodes;
+    std::vector<uint32_t> roots;
+    std::string strings;
+    std::unordered_map<std::string_view, uint32_t> stringOffsets;
+
+    // Post order without recursing, finished holds the index of every node whose parent isn't written yet
+    struct Pending {
+        const Node* node;
+        bool childrenWritten;
+    };
+    std::vector<Pending> pending;
+    std::vector<int32_t> finished;
+    for (const spNode& statement : statements) {
+        pending.push_back({ statement.get(), false });
+        while (!pending.empty()) {
+            Pending next = pending.back();
+            pending.pop_back();
+            const Node& node = *next.node;
+            if (!next.childrenWritten) {
+                pending.push_back({ next.node, true });
+                // Pushed backwards so they are written value, left, right
+                for (const spNode* child : { &node.rightNode, &node.leftNode, &node.valueNode }) {
+                    if (*child != nullptr) pending.push_back({ child->get(), false });
+                }
+                continue;
+            }
+
+            BscNode record = {};
+            BscNodeType type;
+            if (!nodeTypeOf(node.kind, type)) return false;
+            record.type = (uint8_t) type;
+            record.right = node.rightNode != nullptr ? finished.back() : -1;
+            if (node.rightNode != nullptr) finished.pop_back();
+            record.left = node.leftNode != nullptr ? finished.back() : -1;
+            if (node.leftNode != nullptr) finished.pop_back();
+            record.value = node.valueNode != nullptr ? finished.back() : -1;
+            if (node.valueNode != nullptr) finished.pop_back();
+
+            record.tokenKind = (uint8_t) node.token.kind;
+            record.tokenStart = node.token.positionStart.index;
+            record.tokenEnd = node.token.positionEnd.index;
+            record.start = node.positionStart.index;
+            record.end = node.positionEnd.index;
+            auto offset = stringOffsets.find(node.token.value);
+            if (offset == stringOffsets.end()) {
+                offset = stringOffsets.emplace(node.token.value, strings.size()).first;
+                strings += node.token.value;
+            }
+            record.tokenValue = offset->second;
+            record.tokenValueSize = node.token.value.size();
+
+            if (type == BscNodeType::Constant) {
+                const Value& value = node.value;
+                if (value.type == ValueType::Object) return false;
+                record.valueType = (uint8_t) value.type;
+                record.valueFlags = (value.sign ? BscValueFlag::Sign : 0) | (value.isInfinity ? BscValueFlag::Infinity : 0) | (value.isNaN ? BscValueFlag::NaN : 0)
+                    | (value.isPureDouble ? BscValueFlag::PureDouble : 0) | (value.isPureZero ? BscValueFlag::PureZero : 0);
+                record.number = value.doubleValue;
+            }
+
+            finished.push_back(nodes.size());
+            nodes.push_back(record);
+        }
+        roots.push_back(finished.back());
+        finished.pop_back();
+    }
+
+    BscHeader header = {};
+    std::memcpy(header.magic, bscMagic, sizeof(bscMagic));
+    header.version = bscFormatVersion;
+    header.byteOrder = bscByteOrder;
+    header.statementCount = roots.size();
+    header.sourceSize = source.text.size();
+    header.sourceHash = hashSource(source.text);
+    header.nodeCount = nodes.size();
+    header.stringBytes = strings.size();
+
+    // Every thread of every process writes its own temporary file, so two runs of the same script can't mix their writes
+    std::string temporaryPath = path + "." + std::to_string(processId()) + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file) return false;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(nodes.data()), nodes.size() * sizeof(BscNode));
+        file.write(reinterpret_cast<const char*>(roots.data()), roots.size() * sizeof(uint32_t));
+        file.write(strings.data(), strings.size());
+        if (!file) {
+            file.close();
+            std::remove(temporaryPath.c_str());
+            return false;
+        }
+    }
+#ifdef _WIN32
+    // rename doesn't replace an existing file on Windows
+    std::remove(path.c_str());
+#endif
+    if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool readBscFile(const std::string& path, const int& fileId, std::vector<spNode>& statements) {
+    void* mapping;
+    std::size_t size;
+    if (!mapFile(path, mapping, size)) return false;
+    if (size == 0) return false;
+    bool read = readMapped(static_cast<const char*>(mapping), size, fileId, statements);
+    unmapFile(mapping, size);
+    return read;
+}
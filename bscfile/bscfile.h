@@ -0,0 +1,68 @@
+#pragma once
+#ifndef BSCFILE_H
+#define BSCFILE_H
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "../ast/ast.h"
+#include "../source/source.h"
+
+// Bumped whenever the layout below, or what the Parser or Optimizer make from the same source, changes
+const uint32_t bscFormatVersion = 1;
+
+// A .bsc file holds a script's statements after parsing and optimizing, so a later run can skip the Lexer and
+// Parser. Everything is written in the machine's own byte order and rejected on any other:
+//   BscHeader
+//   BscNode[nodeCount], children always come before their parent
+//   uint32_t[statementCount], the node each statement is
+//   char[stringBytes], token values
+struct BscHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t statementCount;
+    // The source the file was made from, it is only used for a source with the same size and hash
+    uint64_t sourceSize;
+    uint64_t sourceHash;
+    uint32_t nodeCount;
+    uint32_t stringBytes;
+};
+
+struct BscNode {
+    // Only used by CONSTANT nodes, with the flags and type below
+    double number;
+    // Source indices, the file comes from whoever loads it
+    int32_t tokenStart;
+    int32_t tokenEnd;
+    int32_t start;
+    int32_t end;
+    // Indices of earlier nodes, -1 for none
+    int32_t left;
+    int32_t right;
+    int32_t value;
+    uint32_t tokenValue;
+    uint32_t tokenValueSize;
+    uint8_t type;
+    uint8_t tokenKind;
+    uint8_t valueType;
+    uint8_t valueFlags;
+};
+
+static_assert(sizeof(BscHeader) == 40, "BscHeader has to have the same layout everywhere");
+static_assert(sizeof(BscNode) == 48, "BscNode has to have the same layout everywhere");
+
+// script.bs is cached in script.bsc, any other name gets .bsc added
+std::string bscPathFor(const std::string& sourcePath);
+
+uint64_t hashSource(const std::string_view& text);
+
+// Writes to a temporary file first and renames it over path, so a reader never sees half a file
+// Returns false if nothing was written, a statement holding an Object can't be written either
+bool writeBscFile(const std::string& path, const SourceFile& source, const std::vector<spNode>& statements);
+
+// Appends the statements cached at path to statements, with nodes and token values in the active Arena and
+// positions in fileId
+// Returns false, and appends nothing, when the file is missing, for another source or version, or damaged
+bool readBscFile(const std::string& path, const int& fileId, std::vector<spNode>& statements);
+
+#endif // !BSCFILE_H
@@ -1 +1 @@
-"C:\Program Files (x86)\Microsoft Visual Studio\2019\BuildTools\VC\Auxiliary\Build\vcvars64.bat" && cl.exe /O2 /EHsc BarkScript.cpp lexer/Lexer.cpp parser/Parser.cpp object/Object.cpp interpreter/Interpreter.cpp symboltable/SymbolTable.cpp /link /out:build/BarkScript.exe
+"C:\Program Files (x86)\Microsoft Visual Studio\2019\BuildTools\VC\Auxiliary\Build\vcvars64.bat" && cl.exe /std:c++17 /O2 /EHsc BarkScript.cpp lexer/Lexer.cpp parser/Parser.cpp object/Object.cpp interpreter/Interpreter.cpp symboltable/SymbolTable.cpp compiler/Compiler.cpp vm/VM.cpp source/Source.cpp object/Operations.cpp arena/Arena.cpp runner/Runner.cpp optimizer/Optimizer.cpp resolver/Resolver.cpp lexer/Scan.cpp error/Error.cpp parsecache/ParseCache.cpp threadpool/ThreadPool.cpp batch/Batch.cpp program/Program.cpp profiler/Profiler.cpp timings/Timings.cpp bscfile/BscFile.cpp jit/Jit.cpp pool/Pool.cpp /link /out:build/BarkScript.exe
@@ -0,0 +1,173 @@
+#pragma once
+#ifndef BYTECODE_H
+#define BYTECODE_H
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "../position/position.h"
+#include "../object/object.h"
+
+// Keep these dense and in the same order as opcodeNames, the VM dispatches on them with a switch
+enum class OpCode : uint8_t {
+    PUSH_CONSTANT, // operand: index into Chunk::constants
+    LOAD_VARIABLE, // operand: index into Chunk::names
+    CHECK_UNDECLARED, // operand: index into Chunk::names
+    DECLARE_VARIABLE, // operand: index into Chunk::names
+    ASSIGN_VARIABLE, // operand: index into Chunk::names
+    LOAD_SLOT, // operand: index into Chunk::slots
+    CHECK_UNDECLARED_SLOT, // operand: index into Chunk::slots
+    DECLARE_SLOT, // operand: index into Chunk::slots
+    ASSIGN_SLOT, // operand: index into Chunk::slots
+
+    BINARY_PLUS,
+    BINARY_MINUS,
+    BINARY_ASTERISK,
+    BINARY_F_SLASH,
+    BINARY_DOUBLE_ASTERISK,
+    BINARY_DOUBLE_F_SLASH,
+    BINARY_DOUBLE_EQUAL,
+    BINARY_BANG_EQUAL,
+    BINARY_LESS_THAN,
+    BINARY_LESS_THAN_EQUAL,
+    BINARY_GREATER_THAN,
+    BINARY_GREATER_THAN_EQUAL,
+
+    UNARY_PLUS,
+    UNARY_MINUS,
+    UNARY_BANG,
+
+    RETURN,
+};
+
+const std::string opcodeNames[] = {
+    "PUSH_CONSTANT",
+    "LOAD_VARIABLE",
+    "CHECK_UNDECLARED",
+    "DECLARE_VARIABLE",
+    "ASSIGN_VARIABLE",
+    "LOAD_SLOT",
+    "CHECK_UNDECLARED_SLOT",
+    "DECLARE_SLOT",
+    "ASSIGN_SLOT",
+
+    "BINARY_PLUS",
+    "BINARY_MINUS",
+    "BINARY_ASTERISK",
+    "BINARY_F_SLASH",
+    "BINARY_DOUBLE_ASTERISK",
+    "BINARY_DOUBLE_F_SLASH",
+    "BINARY_DOUBLE_EQUAL",
+    "BINARY_BANG_EQUAL",
+    "BINARY_LESS_THAN",
+    "BINARY_LESS_THAN_EQUAL",
+    "BINARY_GREATER_THAN",
+    "BINARY_GREATER_THAN_EQUAL",
+
+    "UNARY_PLUS",
+    "UNARY_MINUS",
+    "UNARY_BANG",
+
+    "RETURN",
+};
+
+struct Instruction {
+    OpCode op;
+    int operand = 0;
+};
+
+// The positions an instruction reports errors at, kept out of Instruction so the code array stays small
+struct InstructionSpan {
+    Position positionStart;
+    Position positionEnd;
+    // Where the operands of a BINARY_ or UNARY_ instruction came from, a unary operand is stored as both
+    Position leftStart;
+    Position leftEnd;
+    Position rightStart;
+    Position rightEnd;
+};
+
+// A variable the Resolver bound, depth counts SymbolTable parents up from the running Context's table
+struct SlotReference {
+    int depth;
+    int slot;
+    // Index into Chunk::names, only needed for error messages
+    int name;
+};
+
+struct Chunk {
+    std::vector<Instruction> code;
+    std::vector<InstructionSpan> spans;
+    std::vector<Value> constants;
+    std::vector<std::string> names;
+    std::vector<SlotReference> slots;
+    int maxStackSize = 0;
+
+    void emit(const OpCode& op, const int& operand, const Position& positionStart, const Position& positionEnd) {
+        code.push_back({ op, operand });
+        spans.push_back({ positionStart, positionEnd });
+    }
+
+    void emitOperator(const OpCode& op, const Position& positionStart, const Position& positionEnd, const Position& leftStart, const Position& leftEnd, const Position& rightStart, const Position& rightEnd) {
+        code.push_back({ op, 0 });
+        spans.push_back({ positionStart, positionEnd, leftStart, leftEnd, rightStart, rightEnd });
+    }
+
+    int addConstant(const Value& constant) {
+        constants.push_back(constant);
+        return constants.size() - 1;
+    }
+
+    int addName(const std::string& name) {
+        for (unsigned int i = 0; i < names.size(); i++) {
+            if (names[i] == name) return i;
+        }
+        names.push_back(name);
+        return names.size() - 1;
+    }
+
+    int addSlot(const int& depth, const int& slot, const std::string& name) {
+        slots.push_back({ depth, slot, addName(name) });
+        return slots.size() - 1;
+    }
+
+    std::string to_string() const {
+        std::string output;
+        for (unsigned int i = 0; i < code.size(); i++) {
+            const Instruction& instruction = code[i];
+            output += std::to_string(i) + "\t" + opcodeNames[(int) instruction.op];
+            switch (instruction.op) {
+                case OpCode::PUSH_CONSTANT:
+                {
+                    output += " " + std::to_string(instruction.operand);
+                    break;
+                }
+                case OpCode::LOAD_VARIABLE:
+                case OpCode::CHECK_UNDECLARED:
+                case OpCode::DECLARE_VARIABLE:
+                case OpCode::ASSIGN_VARIABLE:
+                {
+                    output += " " + std::to_string(instruction.operand) + " (" + names[instruction.operand] + ")";
+                    break;
+                }
+                case OpCode::LOAD_SLOT:
+                case OpCode::CHECK_UNDECLARED_SLOT:
+                case OpCode::DECLARE_SLOT:
+                case OpCode::ASSIGN_SLOT:
+                {
+                    const SlotReference& reference = slots[instruction.operand];
+                    output += " " + std::to_string(reference.depth) + ":" + std::to_string(reference.slot) + " (" + names[reference.name] + ")";
+                    break;
+                }
+                default:
+                    break;
+            }
+            output += "\n";
+        }
+        return output;
+    }
+};
+
+typedef std::shared_ptr<Chunk> spChunk;
+
+#endif // !BYTECODE_H
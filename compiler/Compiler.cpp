@@ -0,0 +1,159 @@
+#include "compiler.h"
+#include <string>
+#include <memory>
+#include <vector>
+#include "../ast/ast.h"
+#include "../object/object.h"
+#include "../object/operations.h"
+
+namespace {
+    // The operators are in the same order as their OpCodes, so an operator's OpCode is an offset from the first one
+    static_assert((int) OpCode::BINARY_GREATER_THAN_EQUAL - (int) OpCode::BINARY_PLUS == (int) BinaryOperator::GreaterThanEqual, "BinaryOperator and the BINARY_ OpCodes are out of order");
+    static_assert((int) OpCode::UNARY_BANG - (int) OpCode::UNARY_PLUS == (int) UnaryOperator::Bang, "UnaryOperator and the UNARY_ OpCodes are out of order");
+
+    OpCode opCodeFor(const BinaryOperator& op) {
+        return (OpCode) ((int) OpCode::BINARY_PLUS + (int) op);
+    }
+
+    OpCode opCodeFor(const UnaryOperator& op) {
+        return (OpCode) ((int) OpCode::UNARY_PLUS + (int) op);
+    }
+}
+
+CompileResult Compiler::compile(const spNode& node) {
+    spChunk result = std::make_shared<Chunk>();
+    this->chunk = result.get();
+    this->stackSize = 0;
+
+    const ErrorRecord* error = compileNode(node);
+    if (error) return error;
+    chunk->emit(OpCode::RETURN, 0, node->positionStart, node->positionEnd);
+
+    this->chunk = nullptr;
+    return result;
+}
+
+void Compiler::push() {
+    stackSize++;
+    if (stackSize > chunk->maxStackSize) chunk->maxStackSize = stackSize;
+}
+
+void Compiler::pop(const int& count) {
+    stackSize -= count;
+}
+
+const ErrorRecord* Compiler::compileNode(const spNode& node) {
+    // Without recursing, so any tree the Parser can make can be compiled
+    // Nodes with children are pending twice, their instruction is emitted once their children's are
+    pending.clear();
+    pending.push_back({ &node, false, -1 });
+    while (!pending.empty()) {
+        Pending next = pending.back();
+        pending.pop_back();
+        const spNode& current = *next.node;
+        const ErrorRecord* error = nullptr;
+        if (next.childrenCompiled) {
+            switch (current->kind) {
+                case NodeKind::VariableDeclaration: error = compileVariableDeclarationNode(current, next.variable); break;
+                case NodeKind::VariableAssignment: error = compileVariableAssignmentNode(current, next.variable); break;
+                case NodeKind::BinaryOperator: error = compileBinaryOperatorNode(current); break;
+                case NodeKind::UnaryOperator: error = compileUnaryOperatorNode(current); break;
+                default: break;
+            }
+            if (error) return error;
+            continue;
+        }
+        switch (current->kind) {
+            case NodeKind::Number: error = compileNumberNode(current); break;
+            case NodeKind::Constant: error = compileConstantNode(current); break;
+            case NodeKind::VariableRetrievement: error = compileVariableRetrievementNode(current); break;
+            case NodeKind::VariableDeclaration:
+            {
+                int variable = addVariable(current);
+                // The visitor checks the scope before evaluating the value, so the VM has to as well
+                chunk->emit(current->slot != -1 ? OpCode::CHECK_UNDECLARED_SLOT : OpCode::CHECK_UNDECLARED, variable, current->positionStart, current->positionEnd);
+                pending.push_back({ &current, true, variable });
+                pending.push_back({ &current->valueNode, false, -1 });
+                break;
+            }
+            case NodeKind::VariableAssignment:
+                pending.push_back({ &current, true, addVariable(current) });
+                pending.push_back({ &current->valueNode, false, -1 });
+                break;
+            case NodeKind::BinaryOperator:
+                pending.push_back({ &current, true, -1 });
+                pending.push_back({ &current->rightNode, false, -1 });
+                pending.push_back({ &current->leftNode, false, -1 });
+                break;
+            case NodeKind::UnaryOperator:
+                pending.push_back({ &current, true, -1 });
+                pending.push_back({ &current->rightNode, false, -1 });
+                break;
+            default: return keepErrorRecord(ErrorRecord(ErrorKind::Runtime, MessageId::NodeTypeNotSetUp, current->positionStart, current->positionEnd).with(current->nodeType).with("compile"));
+        }
+        if (error) return error;
+    }
+    return nullptr;
+}
+
+int Compiler::addVariable(const spNode& node) {
+    if (node->slot != -1) return chunk->addSlot(node->depth, node->slot, std::string(node->token.value));
+    return chunk->addName(std::string(node->token.value));
+}
+
+const ErrorRecord* Compiler::compileNumberNode(const spNode& node) {
+    // Decode the literal once here instead of on every run
+    chunk->emit(OpCode::PUSH_CONSTANT, chunk->addConstant(Number(node->token.value)), node->positionStart, node->positionEnd);
+    push();
+    return nullptr;
+}
+
+const ErrorRecord* Compiler::compileConstantNode(const spNode& node) {
+    chunk->emit(OpCode::PUSH_CONSTANT, chunk->addConstant(node->value), node->positionStart, node->positionEnd);
+    push();
+    return nullptr;
+}
+
+const ErrorRecord* Compiler::compileVariableDeclarationNode(const spNode& node, const int& variable) {
+    chunk->emit(node->slot != -1 ? OpCode::DECLARE_SLOT : OpCode::DECLARE_VARIABLE, variable, node->token.positionStart, node->positionEnd);
+    return nullptr;
+}
+
+const ErrorRecord* Compiler::compileVariableAssignmentNode(const spNode& node, const int& variable) {
+    chunk->emit(node->slot != -1 ? OpCode::ASSIGN_SLOT : OpCode::ASSIGN_VARIABLE, variable, node->token.positionStart, node->positionEnd);
+    return nullptr;
+}
+
+const ErrorRecord* Compiler::compileVariableRetrievementNode(const spNode& node) {
+    if (node->slot != -1) {
+        chunk->emit(OpCode::LOAD_SLOT, chunk->addSlot(node->depth, node->slot, std::string(node->token.value)), node->positionStart, node->positionEnd);
+    } else {
+        chunk->emit(OpCode::LOAD_VARIABLE, chunk->addName(std::string(node->token.value)), node->positionStart, node->positionEnd);
+    }
+    push();
+    return nullptr;
+}
+
+const ErrorRecord* Compiler::compileBinaryOperatorNode(const spNode& node) {
+    BinaryOperator op = binaryOperatorFor(node->token.kind);
+    if (op == BinaryOperator::COUNT) {
+        return keepErrorRecord(ErrorRecord(ErrorKind::Runtime, MessageId::OperatorNotSetUp, node->token.positionStart, node->token.positionEnd).with(node->token.type).with("Compiler::compileBinaryOperatorNode"));
+    }
+
+    const spNode& left = node->leftNode;
+    const spNode& right = node->rightNode;
+    chunk->emitOperator(opCodeFor(op), node->positionStart, node->positionEnd, left->positionStart, left->positionEnd, right->positionStart, right->positionEnd);
+    pop();
+    return nullptr;
+}
+
+const ErrorRecord* Compiler::compileUnaryOperatorNode(const spNode& node) {
+    UnaryOperator op = unaryOperatorFor(node->token.kind);
+    if (op == UnaryOperator::COUNT) {
+        return keepErrorRecord(ErrorRecord(ErrorKind::Runtime, MessageId::OperatorNotSetUp, node->token.positionStart, node->token.positionEnd).with(node->token.type).with("Compiler::compileUnaryOperatorNode"));
+    }
+
+    const spNode& operand = node->rightNode;
+    chunk->emitOperator(opCodeFor(op), node->positionStart, node->positionEnd, operand->positionStart, operand->positionEnd, operand->positionStart, operand->positionEnd);
+    return nullptr;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#ifndef COMPILER_H
+#define COMPILER_H
+#include <memory>
+#include <vector>
+#include "../ast/ast.h"
+#include "../bytecode/bytecode.h"
+#include "../error/error.h"
+
+struct CompileResult {
+    spChunk chunk = nullptr;
+    const ErrorRecord* error = nullptr;
+
+    bool hasError() const { return error != nullptr; }
+
+    CompileResult(const spChunk& chunk) {
+        this->chunk = chunk;
+    }
+
+    CompileResult(const ErrorRecord* error) {
+        this->error = error;
+    }
+};
+
+// Lowers the tree from Parser::parse() or Optimizer::optimize() into a Chunk for the VM
+struct Compiler {
+    Chunk* chunk = nullptr;
+    int stackSize = 0;
+
+    CompileResult compile(const spNode& node);
+
+    const ErrorRecord* compileNode(const spNode& node);
+    // These only emit the node's own instruction, after its children's
+    const ErrorRecord* compileNumberNode(const spNode& node);
+    const ErrorRecord* compileConstantNode(const spNode& node);
+    // variable is what addVariable gave the node before its value was compiled
+    const ErrorRecord* compileVariableDeclarationNode(const spNode& node, const int& variable);
+    const ErrorRecord* compileVariableAssignmentNode(const spNode& node, const int& variable);
+    const ErrorRecord* compileVariableRetrievementNode(const spNode& node);
+    const ErrorRecord* compileBinaryOperatorNode(const spNode& node);
+    const ErrorRecord* compileUnaryOperatorNode(const spNode& node);
+
+    // The slot the Resolver bound the node to, or its name when it wasn't bound
+    int addVariable(const spNode& node);
+    void push();
+    void pop(const int& count = 1);
+
+private:
+    // A node to compile, or one whose children were compiled and only its own instruction is left
+    struct Pending {
+        const spNode* node;
+        bool childrenCompiled;
+        // The slot or name a declaration or assignment was given before its value was compiled
+        int variable;
+    };
+    // Kept so its capacity carries over from one statement to the next
+    std::vector<Pending> pending;
+};
+
+#endif // !COMPILER_H
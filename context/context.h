@@ -5,22 +5,30 @@
 #include <string>
 #include "../position/position.h"
 #include "../symboltable/symboltable.h"
+#include "../pool/pool.h"
 
 struct Context;
 
 typedef std::shared_ptr<Context> spContext;
 
+// Ownership only points down: whoever runs code (the Runner, a Program evaluation, a caller) owns its Context and a
+// Context owns its SymbolTable, while parents, Values and ErrorRecords only point at a Context
+// So there is never a cycle to keep one alive, and dropping a Context frees its whole SymbolTable
 struct Context {
     std::string displayName = "UNKNOWN_CONTEXT_NAME";
-    spContext parent;
+    // Outlives this Context, a caller always returns after what it called
+    const Context* parent = nullptr;
     Position parentEntryPosition;
     spSymbolTable symbolTable;
 
-    Context(const std::string& displayName, const spContext& parent = nullptr, const Position& parentEntryPosition = Position()) {
-        this->displayName = displayName;
-        this->parent = parent;
-        this->parentEntryPosition = parentEntryPosition;
-    }
+    // Initialized here rather than assigned, so the default name is never built just to be replaced
+    Context(const std::string& displayName, const Context* parent = nullptr, const Position& parentEntryPosition = Position())
+        : displayName(displayName), parent(parent), parentEntryPosition(parentEntryPosition) {}
 };
 
+// The Context and its control block come from the thread's block pool
+inline spContext makeSharedContext(const std::string& displayName, const Context* parent = nullptr, const Position& parentEntryPosition = Position()) {
+    return std::allocate_shared<Context>(PoolAllocator<Context>(), displayName, parent, parentEntryPosition);
+}
+
 #endif // !CONTEXT_H
@@ -0,0 +1,105 @@
+#include "error.h"
+#include <string>
+#include <cstdio>
+#include <new>
+#include <algorithm>
+
+std::string renderArrows(const Position& positionStart, const Position& positionEnd) {
+    const SourceFile& file = positionStart.file();
+    int lineStart = positionStart.lineNumber();
+    int lineEnd = std::max(lineStart, positionEnd.lineNumber());
+    bool endsOnLastLine = true;
+    // A span that stops right after a line break (a NEWLINE token's does) only reaches to that line break
+    if (lineEnd > lineStart && positionEnd.columnNumber() == 0) {
+        lineEnd--;
+        endsOnLastLine = false;
+    }
+
+    std::string output;
+    for (int line = lineStart; line <= lineEnd; line++) {
+        std::string_view text = file.lineText(line);
+        int columnStart = line == lineStart ? std::max(positionStart.columnNumber(), 0) : 0;
+        int columnEnd = line != lineEnd ? text.size() : endsOnLastLine ? positionEnd.columnNumber() : text.size() + 1;
+        if (line != lineStart) output += '\n';
+
+        int spaces = 0;
+        int arrows = 0;
+        for (int i = 0; i < (int) text.size(); i++) {
+            if (text[i] == '\t') continue;
+            output += text[i];
+            if (i < columnStart) spaces++;
+            else if (i < columnEnd) arrows++;
+        }
+        // The span can run past the end of the text, like an EOF token does
+        spaces += std::max(columnStart - (int) text.size(), 0);
+        arrows += std::max(columnEnd - std::max((int) text.size(), columnStart), 0);
+
+        output += '\n';
+        output.append(spaces, ' ');
+        output.append(arrows, '^');
+    }
+    return output;
+}
+
+const std::string& ErrorRecord::type() const {
+    switch (kind) {
+        case ErrorKind::IllegalChar: return errortypes::IllegalCharError;
+        case ErrorKind::InvalidSyntax: return errortypes::InvalidSyntaxError;
+        case ErrorKind::Type: return errortypes::TypeError;
+        default: return errortypes::RuntimeError;
+    }
+}
+
+std::string ErrorRecord::details() const {
+    std::string first = std::string(arguments[0]);
+    switch (message) {
+        case MessageId::IllegalCharacter: return "'" + first + "'";
+        case MessageId::InvalidUtf8Byte:
+        {
+            char byte[8];
+            std::snprintf(byte, sizeof(byte), "0x%02X", number);
+            return "invalid UTF-8 byte " + std::string(byte);
+        }
+        case MessageId::ExpectedCloseParen: return "Expected a ')'";
+        case MessageId::ExpectedAtom: return "Expected a number, identifier, '+', '-', or a '('";
+        case MessageId::ExpectedIdentifier: return "Expected an identifier";
+        case MessageId::ExpectedEqual: return "Expected an '='";
+        case MessageId::ExpectedStatement: return "Expected a 'let', number, identifier, '+', '-', or a '('";
+        case MessageId::ExpectedOperator: return "Expected a '+', '-', '*', '/', '**', '//', or a '('";
+        case MessageId::DivisionByZero: return "Division by 0";
+        case MessageId::FlooredDivisionByZero: return "Floored division by 0";
+        case MessageId::BinaryNotSupported: return first + " is not supported between the types \"" + std::string(arguments[1]) + "\" and \"" + std::string(arguments[2]) + "\"!";
+        case MessageId::UnaryNotSupported: return first + " is not supported for the type \"" + std::string(arguments[1]) + "\"!";
+        case MessageId::VariableNotDefined: return "Variable \"" + first + "\" is not defined in the current scope!";
+        case MessageId::VariableAlreadyDeclared: return "Variable " + first + " is already declared in the current scope!";
+        case MessageId::VariableNotInScope: return "Variable \"" + first + "\" does not exist in the current scope!";
+        case MessageId::ModifyGlobalConstant: return "You cannot modify a global constant variable!";
+        case MessageId::ModifyConstant: return "You cannot modify a constant variable!";
+        case MessageId::UnknownSetReturnCode: return "Unknown return value when setting: " + std::to_string(number);
+        case MessageId::NodeTypeNotSetUp: return "Error: node type " + first + " does not have a " + std::string(arguments[1]) + " method!";
+        case MessageId::OperatorNotSetUp: return first + " is not set up in " + std::string(arguments[1]);
+        case MessageId::OpcodeNotSetUp: return "Error: opcode " + std::to_string(number) + " is not set up in VM::run";
+        default: return "Unknown error message " + std::to_string((int) message);
+    }
+}
+
+std::string ErrorRecord::to_string() const {
+    switch (kind) {
+        case ErrorKind::IllegalChar: return IllegalCharError(positionStart, positionEnd, details()).to_string();
+        case ErrorKind::InvalidSyntax: return InvalidSyntaxError(positionStart, positionEnd, details()).to_string();
+        case ErrorKind::Type: return TypeError(positionStart, positionEnd, details(), context).to_string();
+        default: return RuntimeError(positionStart, positionEnd, details(), context).to_string();
+    }
+}
+
+std::string ErrorRecord::to_line() const {
+    return positionStart.filename() + ':' + std::to_string(positionStart.lineNumber() + 1) + ':' + std::to_string(positionStart.columnNumber() + 1) + ": " + type() + ": " + details();
+}
+
+// Only for errors made while no Arena is active, which nothing in the interpreter does
+thread_local Arena fallbackErrorArena;
+
+const ErrorRecord* keepErrorRecord(const ErrorRecord& record) {
+    Arena* arena = activeArena != nullptr ? activeArena : &fallbackErrorArena;
+    return new (arena->allocate(sizeof(ErrorRecord), alignof(ErrorRecord))) ErrorRecord(record);
+}
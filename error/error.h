@@ -2,9 +2,12 @@
 #ifndef ERROR_H
 #define ERROR_H
 #include <string>
+#include <string_view>
+#include <cstdint>
+#include <type_traits>
 #include "../position/position.h"
 #include "../context/context.h"
-#include "../vendor/strings_with_arrows/strings_with_arrows.h"
+#include "../arena/arena.h"
 
 namespace errortypes {
     using namespace std;
@@ -17,14 +20,18 @@ namespace errortypes {
 
 struct Error;
 
+// Every source line from positionStart to positionEnd with ^ under the span, tabs are left out of both
+std::string renderArrows(const Position& positionStart, const Position& positionEnd);
+
 typedef std::shared_ptr<Error> spError;
 
 // Polymorphism without having to cast to unknown types later on
 // https://stackoverflow.com/a/42539569/12101554
 // https://ideone.com/4jdhfZ
+// Errors come from the active Arena too, they are reported before the statement's arena is reset
 template<class ErrorType>
 spError makeSharedError(ErrorType&& error) {
-    return std::make_shared<std::remove_reference_t<ErrorType>>(std::forward<ErrorType>(error));
+    return makeArenaShared<std::remove_reference_t<ErrorType>>(std::forward<ErrorType>(error));
 }
 
 struct Error {
@@ -46,12 +53,17 @@ struct Error {
 
     std::string virtual to_string() const {
         std::string output = type + ": " + details + '\n';
-        output += "File \"" + positionStart.filename + "\", line " + std::to_string(positionStart.lineNumber + 1);
+        output += "File \"" + positionStart.filename() + "\", line " + std::to_string(positionStart.lineNumber() + 1);
         output += "\n\n";
-        output += strings_with_arrows(positionStart.filetext, positionStart, positionEnd);
+        output += renderArrows(positionStart, positionEnd);
         return output;
     }
 
+    // file:line:column: type: details, with no traceback or source, for editors and other tools reading the output
+    std::string to_line() const {
+        return positionStart.filename() + ':' + std::to_string(positionStart.lineNumber() + 1) + ':' + std::to_string(positionStart.columnNumber() + 1) + ": " + type + ": " + details;
+    }
+
     virtual operator spError() = 0;
     // All children should have the code below
     //operator spError() override {
@@ -88,11 +100,11 @@ struct InvalidSyntaxError : Error {
 };
 
 struct RuntimeError : Error {
-    spContext context;
+    const Context* context = nullptr;
 
     RuntimeError() {}
 
-    RuntimeError(const Position& positionStart, const Position& positionEnd, const std::string&& details, const spContext& context) {
+    RuntimeError(const Position& positionStart, const Position& positionEnd, const std::string&& details, const Context* context) {
         this->positionStart = positionStart;
         this->positionEnd = positionEnd;
         this->type = errortypes::RuntimeError;
@@ -104,17 +116,17 @@ struct RuntimeError : Error {
         std::string output = generateTraceback();
         output += type + ": " + details;
         output += "\n\n";
-        output += strings_with_arrows(positionStart.filetext, positionStart, positionEnd);
+        output += renderArrows(positionStart, positionEnd);
         return output;
     }
 
     std::string generateTraceback() const {
         std::string output = "";
         const Position* pos = &positionStart;
-        spContext ctx = context;
+        const Context* ctx = context;
 
         while (ctx != nullptr) {
-            output = "  File \"" + pos->filename + "\", line " + std::to_string(pos->lineNumber) + ", in \"" + ctx->displayName + "\"\n" + output;
+            output = "  File \"" + pos->filename() + "\", line " + std::to_string(pos->lineNumber()) + ", in \"" + ctx->displayName + "\"\n" + output;
             pos = &ctx->parentEntryPosition;
             ctx = ctx->parent;
         }
@@ -128,7 +140,7 @@ struct RuntimeError : Error {
 };
 
 struct TypeError : RuntimeError {
-    TypeError(const Position& positionStart, const Position& positionEnd, const std::string&& details, const spContext& context) {
+    TypeError(const Position& positionStart, const Position& positionEnd, const std::string&& details, const Context* context) {
         this->type = errortypes::TypeError;
         this->positionStart = positionStart;
         this->positionEnd = positionEnd;
@@ -141,4 +153,82 @@ struct TypeError : RuntimeError {
     }
 };
 
+enum class ErrorKind : uint8_t {
+    IllegalChar,
+    InvalidSyntax,
+    Runtime,
+    Type,
+};
+
+// Every message an ErrorRecord can turn into, the text itself is only built by ErrorRecord::details()
+enum class MessageId : uint8_t {
+    IllegalCharacter, // arguments: the character
+    InvalidUtf8Byte, // number: the byte
+    ExpectedCloseParen,
+    ExpectedAtom,
+    ExpectedIdentifier,
+    ExpectedEqual,
+    ExpectedStatement,
+    ExpectedOperator,
+    DivisionByZero,
+    FlooredDivisionByZero,
+    BinaryNotSupported, // arguments: operation, left type, right type
+    UnaryNotSupported, // arguments: operation, type
+    VariableNotDefined, // arguments: name
+    VariableAlreadyDeclared, // arguments: name
+    VariableNotInScope, // arguments: name
+    ModifyGlobalConstant,
+    ModifyConstant,
+    UnknownSetReturnCode, // number: the SymbolTableSetReturnCode
+    NodeTypeNotSetUp, // arguments: node type, "visit" or "compile"
+    OperatorNotSetUp, // arguments: operator token type, function
+    OpcodeNotSetUp, // number: the OpCode
+};
+
+// What the Lexer, Parser, Compiler and engines pass around instead of a full Error
+// It's small, trivially destructible and nothing is formatted until the error is reported with to_string()
+// The arguments are views, so they have to be source text, Chunk names, node types or type names, which all
+// outlive the statement's report
+struct ErrorRecord {
+    ErrorKind kind;
+    MessageId message;
+    uint8_t argumentCount = 0;
+    Position positionStart;
+    Position positionEnd;
+    std::string_view arguments[3];
+    int number = 0;
+    // Where a Runtime or Type error's traceback starts
+    const Context* context = nullptr;
+
+    ErrorRecord(const ErrorKind& kind, const MessageId& message, const Position& positionStart, const Position& positionEnd, const Context* context = nullptr) {
+        this->kind = kind;
+        this->message = message;
+        this->positionStart = positionStart;
+        this->positionEnd = positionEnd;
+        this->context = context;
+    }
+
+    ErrorRecord& with(const std::string_view& argument) {
+        arguments[argumentCount++] = argument;
+        return *this;
+    }
+
+    ErrorRecord& withNumber(const int& number) {
+        this->number = number;
+        return *this;
+    }
+
+    const std::string& type() const;
+    std::string details() const;
+    // Builds the matching Error and renders it
+    std::string to_string() const;
+    // Same as Error::to_line(), without building the Error
+    std::string to_line() const;
+};
+
+static_assert(std::is_trivially_destructible<ErrorRecord>::value, "ErrorRecords are dropped with the Arena without being destroyed");
+
+// Copies a record into the active Arena (or one that is never reset when there isn't one) so results only carry a pointer
+const ErrorRecord* keepErrorRecord(const ErrorRecord& record);
+
 #endif // !ERROR_H
@@ -3,167 +3,352 @@
 #include <string>
 #include "../ast/ast.h"
 #include "../object/object.h"
+#include "../object/operations.h"
+#include "../jit/jit.h"
+
+namespace {
+    // Indexed by Quickening::operation, which is the BinaryOperator or UnaryOperator
+    const QuickBinaryOperation quickBinaryOperations[] = {
+        &quick_binary_plus,
+        &quick_binary_minus,
+        &quick_binary_asterisk,
+        &quick_binary_f_slash,
+        &quick_binary_double_asterisk,
+        &quick_binary_double_f_slash,
+        &quick_binary_double_equal,
+        &quick_binary_bang_equal,
+        &quick_binary_less_than,
+        &quick_binary_less_than_equal,
+        &quick_binary_greater_than,
+        &quick_binary_greater_than_equal,
+    };
+
+    const QuickUnaryOperation quickUnaryOperations[] = {
+        &quick_unary_plus,
+        &quick_unary_minus,
+        &quick_unary_bang,
+    };
+
+    // How many evaluations in a row have to see the same operand types before a node specializes to them
+    const uint8_t warmupEvaluations = 2;
+    // A node that had to deoptimize this many times keeps the generic operator
+    const uint8_t maximumDeoptimizations = 4;
+
+    int8_t binaryOperationIndex(const TokenKind& kind) {
+        BinaryOperator op = binaryOperatorFor(kind);
+        return op == BinaryOperator::COUNT ? -1 : (int8_t) op;
+    }
+
+    int8_t unaryOperationIndex(const TokenKind& kind) {
+        UnaryOperator op = unaryOperatorFor(kind);
+        return op == UnaryOperator::COUNT ? -1 : (int8_t) op;
+    }
+
+    // Operands without children of their own are evaluated by their parent's dispatch, which saves going through
+    // pending for most of the nodes in a tree
+    bool isLeaf(const Node& node) {
+        return node.kind == NodeKind::Constant || node.kind == NodeKind::VariableRetrievement || node.kind == NodeKind::Number;
+    }
+
+    // What every specialized operator's guard checks besides the types, the flags are the generic operators' special cases
+    bool isQuickenable(const Value& value) {
+        return value.isNumeric() && !value.isInfinity && !value.isNaN;
+    }
+
+    // Called after each generic evaluation of a warming node, quickenable says whether every operand could be specialized for
+    void warm(Quickening& quickening, const ValueType& left, const ValueType& right, const bool& quickenable, QuickeningStats* stats) {
+        if (!quickenable) {
+            quickening.warmups = 0;
+            return;
+        }
+        if (quickening.warmups == 0 || quickening.left != left || quickening.right != right) {
+            quickening.left = left;
+            quickening.right = right;
+            quickening.warmups = 0;
+        }
+        if (++quickening.warmups < warmupEvaluations) return;
+        quickening.state = QuickeningState::Specialized;
+        if (stats != nullptr) stats->specializations++;
+    }
+
+    void deoptimize(Quickening& quickening, QuickeningStats* stats) {
+        quickening.warmups = 0;
+        quickening.state = ++quickening.deoptimizations < maximumDeoptimizations ? QuickeningState::Warming : QuickeningState::Generic;
+        if (stats != nullptr) stats->misses++;
+    }
+}
 
 bool RuntimeResult::hasError() const { return error != nullptr; }
 
-spObject RuntimeResult::registerRT(const spObject& object) {
-    return object;
+Value RuntimeResult::registerRT(const Value& value) {
+    return value;
 }
 
-spObject RuntimeResult::registerRT(const RuntimeResult& rt) {
+Value RuntimeResult::registerRT(const RuntimeResult& rt) {
     if (rt.hasError()) {
         this->error = rt.error;
     }
-    return rt.object;
+    return rt.value;
 }
 
-RuntimeResult RuntimeResult::success(const spObject& object) {
-    this->object = object;
-    return *this;
+RuntimeResult RuntimeResult::success(const Value& value) {
+    this->value = value;
+    return std::move(*this);
 }
 
-RuntimeResult RuntimeResult::failure(const spError& error) {
+RuntimeResult RuntimeResult::failure(const ErrorRecord& error) {
+    this->error = keepErrorRecord(error);
+    return std::move(*this);
+}
+
+RuntimeResult RuntimeResult::failure(const ErrorRecord* error) {
     this->error = error;
-    return *this;
+    return std::move(*this);
 }
 
 RuntimeResult Interpreter::visit(const spNode& node, const spContext& context) {
-    std::string type = node->nodeType;
-
-    if (type == nodetypes::Number) {
-        return visitNumberNode(node, context);
-    } else if (type == nodetypes::VariableDeclaration) {
-        return visitVariableDeclarationNode(node, context);
-    } else if (type == nodetypes::VariableAssignment) {
-        return visitVariableAssignmentNode(node, context);
-    } else if (type == nodetypes::VariableRetrievement) {
-        return visitVariableRetrievementNode(node, context);
-    } else if (type == nodetypes::BinaryOperator) {
-        return visitBinaryOperatorNode(node, context);
-    } else if (type == nodetypes::UnaryOperator) {
-        return visitUnaryOperatorNode(node, context);
+    if (profiler != nullptr) return visitNode<true>(node, context);
+    return visitNode<false>(node, context);
+}
+
+template<bool Profiled>
+RuntimeResult Interpreter::visitNode(const spNode& node, const spContext& context) {
+    // Without recursing, so any tree the Parser can make can be evaluated
+    // Nodes with children are pending twice, by the time they come up again their operands are on top of values
+    pending.clear();
+    values.clear();
+    pending.push_back({ &node, false });
+    while (!pending.empty()) {
+        Pending next = pending.back();
+        pending.pop_back();
+        const spNode& current = *next.node;
+        const ErrorRecord* error = next.childrenVisited ? finish<Profiled>(current, context) : dispatch<Profiled>(current, context);
+        if (error == nullptr) continue;
+        // Every node that was entered and not finished yet still has its frame
+        if constexpr (Profiled) {
+            profiler->exit();
+            for (const Pending& entered : pending) {
+                if (entered.childrenVisited) profiler->exit();
+            }
+        }
+        values.clear();
+        return RuntimeResult().failure(error);
+    }
+    RuntimeResult rt;
+    rt.value = std::move(values.back());
+    values.pop_back();
+    return rt;
+}
+
+template<bool Profiled>
+const ErrorRecord* Interpreter::dispatch(const spNode& node, const spContext& context) {
+    if constexpr (Profiled) {
+        profiler->enterNode(*node);
     } else {
-        return RuntimeResult().failure(RuntimeError(node->positionStart, node->positionEnd, "Error: node type " + type + " does not have a visit method!", context));
+        // A profile times what the Interpreter does, so it never takes the native code
+        if (node->jitFunction != nullptr) {
+            Value value;
+            // Anything the code bailed out on is evaluated below, where it gets its Infinity, NaN or error
+            if (node->jitFunction->run(context, value)) {
+                values.push_back(std::move(value));
+                return nullptr;
+            }
+        }
+    }
+    const ErrorRecord* error = nullptr;
+    switch (node->kind) {
+        case NodeKind::Number: error = visitNumberNode(node, context); break;
+        case NodeKind::Constant: error = visitConstantNode(node, context); break;
+        case NodeKind::VariableRetrievement: error = visitVariableRetrievementNode(node, context); break;
+        case NodeKind::VariableDeclaration:
+            // The scope is checked before the value is evaluated
+            error = checkVariableDeclarationNode(node, context);
+            if (error != nullptr) return error;
+            pending.push_back({ &node, true });
+            pending.push_back({ &node->valueNode, false });
+            return nullptr;
+        case NodeKind::VariableAssignment:
+            pending.push_back({ &node, true });
+            pending.push_back({ &node->valueNode, false });
+            return nullptr;
+        case NodeKind::BinaryOperator:
+            if (isLeaf(*node->leftNode) && isLeaf(*node->rightNode)) {
+                error = dispatch<Profiled>(node->leftNode, context);
+                if (error == nullptr) error = dispatch<Profiled>(node->rightNode, context);
+                if (error == nullptr) return finish<Profiled>(node, context);
+                // The operand's frame is closed here, visitNode closes this node's
+                if constexpr (Profiled) profiler->exit();
+                return error;
+            }
+            pending.push_back({ &node, true });
+            pending.push_back({ &node->rightNode, false });
+            pending.push_back({ &node->leftNode, false });
+            return nullptr;
+        case NodeKind::UnaryOperator:
+            if (isLeaf(*node->rightNode)) {
+                error = dispatch<Profiled>(node->rightNode, context);
+                if (error == nullptr) return finish<Profiled>(node, context);
+                if constexpr (Profiled) profiler->exit();
+                return error;
+            }
+            pending.push_back({ &node, true });
+            pending.push_back({ &node->rightNode, false });
+            return nullptr;
+        default: return keepErrorRecord(ErrorRecord(ErrorKind::Runtime, MessageId::NodeTypeNotSetUp, node->positionStart, node->positionEnd, context.get()).with(node->nodeType).with("visit"));
+    }
+    if constexpr (Profiled) {
+        if (error == nullptr) profiler->exit();
     }
+    return error;
 }
 
-RuntimeResult Interpreter::visitNumberNode(const spNode& node, const spContext& context) {
-    spObject number = Number(node->token.value);
-    number->setContext(context);
-    number->setPosition(node->positionStart, node->positionEnd);
-    return RuntimeResult().success(number);
+template<bool Profiled>
+const ErrorRecord* Interpreter::finish(const spNode& node, const spContext& context) {
+    const ErrorRecord* error = nullptr;
+    switch (node->kind) {
+        case NodeKind::VariableDeclaration: error = visitVariableDeclarationNode(node, context); break;
+        case NodeKind::VariableAssignment: error = visitVariableAssignmentNode(node, context); break;
+        case NodeKind::BinaryOperator: error = visitBinaryOperatorNode<Profiled>(node, context); break;
+        case NodeKind::UnaryOperator: error = visitUnaryOperatorNode<Profiled>(node, context); break;
+        default: break;
+    }
+    if constexpr (Profiled) {
+        if (error == nullptr) profiler->exit();
+    }
+    return error;
 }
 
-RuntimeResult Interpreter::visitVariableDeclarationNode(const spNode& node, const spContext& context) {
-    RuntimeResult rt;
-    std::string variableName = node->token.value;
-    if (context->symbolTable->exists(variableName, false)) {
-        return rt.failure(RuntimeError(node->positionStart, node->positionEnd, "Variable " + variableName + " is already declared in the current scope!", context));
-    }
-    spObject value;
-    value = rt.registerRT(visit(node->valueNode, context));
-    if (rt.hasError()) return rt;
-    SymbolTableSetReturnCode success = context->symbolTable->set(variableName, value, true);
-    switch (success) {
-        case SymbolTableSetReturnCode::perfect: { return rt.success(value); }
-        case SymbolTableSetReturnCode::errorGlobalConstantVariable: { return rt.failure(RuntimeError(node->token.positionStart, node->positionEnd, "You cannot modify a global constant variable!", context)); }
-        case SymbolTableSetReturnCode::errorUserDefinedConstantVariable: { return rt.failure(RuntimeError(node->token.positionStart, node->positionEnd, "You cannot modify a constant variable!", context)); }
-        case SymbolTableSetReturnCode::errorNotInScope: { return rt.failure(RuntimeError(node->token.positionStart, node->positionEnd, "Variable \"" + variableName + "\" does not exist in the current scope!", context)); }
-        default: { return rt.failure(RuntimeError(node->token.positionStart, node->positionEnd, "Unknown return value when setting: " + std::to_string((int) success), context)); }
+const ErrorRecord* Interpreter::visitNumberNode(const spNode& node, const spContext& context) {
+    values.push_back(Number(node->token.value));
+    return nullptr;
+}
+
+const ErrorRecord* Interpreter::visitConstantNode(const spNode& node, const spContext& context) {
+    values.push_back(node->value);
+    return nullptr;
+}
+
+const ErrorRecord* Interpreter::checkVariableDeclarationNode(const spNode& node, const spContext& context) {
+    bool declared = node->slot != -1 ? context->symbolTable->ancestor(node->depth)->getSlot(node->slot) != nullptr : context->symbolTable->exists(std::string(node->token.value), false);
+    if (!declared) return nullptr;
+    return keepErrorRecord(ErrorRecord(ErrorKind::Runtime, MessageId::VariableAlreadyDeclared, node->positionStart, node->positionEnd, context.get()).with(node->token.value));
+}
+
+const ErrorRecord* Interpreter::visitVariableDeclarationNode(const spNode& node, const spContext& context) {
+    // The value stays on values as the declaration's result
+    const Value& value = values.back();
+    if (node->slot != -1) {
+        context->symbolTable->ancestor(node->depth)->setSlot(node->slot, value);
+        return nullptr;
     }
+    return setVariable(node, context, value, true);
 }
 
-RuntimeResult Interpreter::visitVariableAssignmentNode(const spNode& node, const spContext& context) {
-    RuntimeResult rt;
-    std::string variableName = node->token.value;
-    spObject value = rt.registerRT(visit(node->valueNode, context));
-    if (rt.hasError()) return rt;
-    SymbolTableSetReturnCode success = context->symbolTable->set(variableName, value, false);
+const ErrorRecord* Interpreter::visitVariableAssignmentNode(const spNode& node, const spContext& context) {
+    const Value& value = values.back();
+    if (node->slot != -1) {
+        context->symbolTable->ancestor(node->depth)->setSlot(node->slot, value);
+        return nullptr;
+    }
+    return setVariable(node, context, value, false);
+}
+
+const ErrorRecord* Interpreter::setVariable(const spNode& node, const spContext& context, const Value& value, const bool& declaration) {
+    SymbolTableSetReturnCode success = context->symbolTable->set(std::string(node->token.value), value, declaration);
     switch (success) {
-        case SymbolTableSetReturnCode::perfect: { return rt.success(value); }
-        case SymbolTableSetReturnCode::errorGlobalConstantVariable: { return rt.failure(RuntimeError(node->token.positionStart, node->positionEnd, "You cannot modify a global constant variable!", context)); }
-        case SymbolTableSetReturnCode::errorUserDefinedConstantVariable: { return rt.failure(RuntimeError(node->token.positionStart, node->positionEnd, "You cannot modify a constant variable!", context)); }
-        case SymbolTableSetReturnCode::errorNotInScope: { return rt.failure(RuntimeError(node->token.positionStart, node->positionEnd, "Variable \"" + variableName + "\" does not exist in the current scope!", context)); }
-        default: { return rt.failure(RuntimeError(node->token.positionStart, node->positionEnd, "Unknown return value when setting: " + std::to_string((int) success), context)); }
+        case SymbolTableSetReturnCode::perfect: { return nullptr; }
+        case SymbolTableSetReturnCode::errorGlobalConstantVariable: { return keepErrorRecord(ErrorRecord(ErrorKind::Runtime, MessageId::ModifyGlobalConstant, node->token.positionStart, node->positionEnd, context.get())); }
+        case SymbolTableSetReturnCode::errorUserDefinedConstantVariable: { return keepErrorRecord(ErrorRecord(ErrorKind::Runtime, MessageId::ModifyConstant, node->token.positionStart, node->positionEnd, context.get())); }
+        case SymbolTableSetReturnCode::errorNotInScope: { return keepErrorRecord(ErrorRecord(ErrorKind::Runtime, MessageId::VariableNotInScope, node->token.positionStart, node->positionEnd, context.get()).with(node->token.value)); }
+        default: { return keepErrorRecord(ErrorRecord(ErrorKind::Runtime, MessageId::UnknownSetReturnCode, node->token.positionStart, node->positionEnd, context.get()).withNumber((int) success)); }
     }
 }
 
-RuntimeResult Interpreter::visitVariableRetrievementNode(const spNode& node, const spContext& context) {
-    RuntimeResult rt;
-    std::string variableName = node->token.value;
-    spObject value = context->symbolTable->get(variableName);
+const ErrorRecord* Interpreter::visitVariableRetrievementNode(const spNode& node, const spContext& context) {
+    const Value* value = node->slot != -1 ? context->symbolTable->ancestor(node->depth)->getSlot(node->slot) : context->symbolTable->get(std::string(node->token.value));
     if (value == nullptr)
-        return rt.failure(RuntimeError(node->positionStart, node->positionEnd, "Variable \"" + variableName + "\" is not defined in the current scope!", context));
-    value = value->copy();
-    value->setContext(context);
-    value->setPosition(node->positionStart, node->positionEnd);
-    return rt.success(value);
+        return keepErrorRecord(ErrorRecord(ErrorKind::Runtime, MessageId::VariableNotDefined, node->positionStart, node->positionEnd, context.get()).with(node->token.value));
+    values.push_back(*value);
+    return nullptr;
 }
 
-RuntimeResult Interpreter::visitBinaryOperatorNode(const spNode& node, const spContext& context) {
-    RuntimeResult rt;
-    spObject left = rt.registerRT(visit(node->leftNode, context));
-    if (rt.hasError()) return rt;
-    spObject right = rt.registerRT(visit(node->rightNode, context));
-    if (rt.hasError()) return rt;
-
-    RuntimeResult result;
-
-    std::string optoken = node->token.type;
-    if (optoken == tokens::PLUS) {
-        result = left->binary_plus(right);
-    } else if (optoken == tokens::MINUS) {
-        result = left->binary_minus(right);
-    } else if (optoken == tokens::ASTERISK) {
-        result = left->binary_asterisk(right);
-    } else if (optoken == tokens::F_SLASH) {
-        result = left->binary_f_slash(right);
-    } else if (optoken == tokens::DOUBLE_ASTERISK) {
-        result = left->binary_double_asterisk(right);
-    } else if (optoken == tokens::DOUBLE_F_SLASH) {
-        result = left->binary_double_f_slash(right);
-    } else if (optoken == tokens::DOUBLE_EQUAL) {
-        result = left->binary_double_equal(right);
-    } else if (optoken == tokens::BANG_EQUAL) {
-        result = left->binary_bang_equal(right);
-    } else if (optoken == tokens::LESS_THAN) {
-        result = left->binary_less_than(right);
-    } else if (optoken == tokens::LESS_THAN_EQUAL) {
-        result = left->binary_less_than_equal(right);
-    } else if (optoken == tokens::GREATER_THAN) {
-        result = left->binary_greater_than(right);
-    } else if (optoken == tokens::GREATER_THAN_EQUAL) {
-        result = left->binary_greater_than_equal(right);
-    } else {
-        return result.failure(RuntimeError(node->token.positionStart, node->token.positionEnd, optoken + " is not set up in Interpreter::visitBinaryOperatorNode", context));
+template<bool Profiled>
+const ErrorRecord* Interpreter::visitBinaryOperatorNode(const spNode& node, const spContext& context) {
+    // Both operands are replaced by the result
+    const Value& right = values.back();
+    const Value& left = values[values.size() - 2];
+
+    OperationSite site = { node->leftNode->positionStart, node->leftNode->positionEnd, node->rightNode->positionStart, node->rightNode->positionEnd, context };
+
+    if constexpr (Profiled) profiler->enterOperation(node->token, false);
+    Quickening& quickening = node->quickening;
+    if (quickening.state == QuickeningState::Specialized) {
+        if (left.type == quickening.left && right.type == quickening.right && isQuickenable(left) && isQuickenable(right)) {
+            Value value;
+            if (quickBinaryOperations[quickening.operation](left, right, value)) {
+                if constexpr (Profiled) profiler->exit();
+                if (quickeningStats != nullptr) quickeningStats->hits++;
+                values.pop_back();
+                values.back() = std::move(value);
+                return nullptr;
+            }
+        } else {
+            deoptimize(quickening, quickeningStats);
+        }
+    } else if (quickening.state == QuickeningState::Unresolved) {
+        quickening.operation = binaryOperationIndex(node->token.kind);
+        quickening.state = QuickeningState::Warming;
     }
+    if (quickening.operation == -1) {
+        if constexpr (Profiled) profiler->exit();
+        return keepErrorRecord(ErrorRecord(ErrorKind::Runtime, MessageId::OperatorNotSetUp, node->token.positionStart, node->token.positionEnd, context.get()).with(node->token.type).with("Interpreter::visitBinaryOperatorNode"));
+    }
+    RuntimeResult result = binaryOperation((BinaryOperator) quickening.operation, left, right, site);
+    if constexpr (Profiled) profiler->exit();
+    if (quickeningStats != nullptr) quickeningStats->generic++;
+    if (quickening.state == QuickeningState::Warming) warm(quickening, left.type, right.type, isQuickenable(left) && isQuickenable(right), quickeningStats);
 
-    if (result.hasError()) return rt.failure(result.error);
+    if (result.hasError()) return result.error;
 
-    result.object->setPosition(node->positionStart, node->positionEnd);
-    return rt.success(result.object);
+    values.pop_back();
+    values.back() = std::move(result.value);
+    return nullptr;
 }
 
-RuntimeResult Interpreter::visitUnaryOperatorNode(const spNode& node, const spContext& context) {
-    RuntimeResult rt;
-    spObject object = rt.registerRT(visit(node->rightNode, context));
-    if (rt.hasError()) return rt;
-
-    RuntimeResult result;
-
-    std::string optoken = node->token.type;
-    if (optoken == tokens::PLUS) {
-        result = object->unary_plus();
-    } else if (optoken == tokens::MINUS) {
-        result = object->unary_minus();
-    } else if (optoken == tokens::BANG) {
-        result = object->unary_bang();
-    } else {
-        return result.failure(RuntimeError(node->token.positionStart, node->token.positionEnd, optoken + " is not set up in Interpreter::visitUnaryOperatorNode", context));
+template<bool Profiled>
+const ErrorRecord* Interpreter::visitUnaryOperatorNode(const spNode& node, const spContext& context) {
+    // The operand is replaced by the result
+    Value& value = values.back();
+
+    OperationSite site = { node->rightNode->positionStart, node->rightNode->positionEnd, node->rightNode->positionStart, node->rightNode->positionEnd, context };
+
+    if constexpr (Profiled) profiler->enterOperation(node->token, true);
+    Quickening& quickening = node->quickening;
+    if (quickening.state == QuickeningState::Specialized) {
+        if (value.type == quickening.left && isQuickenable(value)) {
+            Value quickResult;
+            quickUnaryOperations[quickening.operation](value, quickResult);
+            if constexpr (Profiled) profiler->exit();
+            if (quickeningStats != nullptr) quickeningStats->hits++;
+            value = std::move(quickResult);
+            return nullptr;
+        }
+        deoptimize(quickening, quickeningStats);
+    } else if (quickening.state == QuickeningState::Unresolved) {
+        quickening.operation = unaryOperationIndex(node->token.kind);
+        quickening.state = QuickeningState::Warming;
+    }
+    if (quickening.operation == -1) {
+        if constexpr (Profiled) profiler->exit();
+        return keepErrorRecord(ErrorRecord(ErrorKind::Runtime, MessageId::OperatorNotSetUp, node->token.positionStart, node->token.positionEnd, context.get()).with(node->token.type).with("Interpreter::visitUnaryOperatorNode"));
     }
+    RuntimeResult result = unaryOperation((UnaryOperator) quickening.operation, value, site);
+    if constexpr (Profiled) profiler->exit();
+    if (quickeningStats != nullptr) quickeningStats->generic++;
+    if (quickening.state == QuickeningState::Warming) warm(quickening, value.type, ValueType::Null, isQuickenable(value), quickeningStats);
 
-    if (result.hasError()) return rt.failure(result.error);
+    if (result.hasError()) return result.error;
 
-    result.object->setPosition(node->positionStart, node->positionEnd);
-    return rt.success(result.object);
+    value = std::move(result.value);
+    return nullptr;
 }
@@ -2,34 +2,65 @@
 #ifndef INTERPRETER_H
 #define INTERPRETER_H
 #include <memory>
+#include <vector>
 #include "../ast/ast.h"
 #include "../context/context.h"
 #include "../error/error.h"
+#include "../object/object.h"
+#include "../profiler/profiler.h"
+#include "quickening.h"
 
-struct Object;
-typedef std::shared_ptr<Object> spObject;
-
+// Either a Value or the ErrorRecord saying why there isn't one, returning it never touches the heap
 struct RuntimeResult {
-    spError error = nullptr;
-    spObject object = nullptr;
+    const ErrorRecord* error = nullptr;
+    Value value;
 
     bool hasError() const;
-    spObject registerRT(const spObject& object);
-    spObject registerRT(const RuntimeResult& rt);
+    Value registerRT(const Value& value);
+    Value registerRT(const RuntimeResult& rt);
 
-    RuntimeResult success(const spObject& object);
-    RuntimeResult failure(const spError& error);
+    RuntimeResult success(const Value& value);
+    RuntimeResult failure(const ErrorRecord& error);
+    RuntimeResult failure(const ErrorRecord* error);
 };
 
 struct Interpreter {
+    // Records every node and operator call while set
+    // The walk is compiled once with profiling and once without, and only visit() looks at this, so leaving it
+    // unset costs nothing per node
+    Profiler* profiler = nullptr;
+    // Operator nodes specialize themselves either way, this only counts how that went
+    QuickeningStats* quickeningStats = nullptr;
+
     RuntimeResult visit(const spNode& node, const spContext& context);
 
-    RuntimeResult visitNumberNode(const spNode& node, const spContext& context);
-    RuntimeResult visitVariableDeclarationNode(const spNode& node, const spContext& context);
-    RuntimeResult visitVariableAssignmentNode(const spNode& node, const spContext& context);
-    RuntimeResult visitVariableRetrievementNode(const spNode& node, const spContext& context);
-    RuntimeResult visitBinaryOperatorNode(const spNode& node, const spContext& context);
-    RuntimeResult visitUnaryOperatorNode(const spNode& node, const spContext& context);
+    template<bool Profiled> RuntimeResult visitNode(const spNode& node, const spContext& context);
+    // Evaluates a node without children, or pushes the ones it has
+    template<bool Profiled> const ErrorRecord* dispatch(const spNode& node, const spContext& context);
+    // Evaluates a node whose children were evaluated onto values
+    template<bool Profiled> const ErrorRecord* finish(const spNode& node, const spContext& context);
+    // These push the node's result onto values, or replace its operands there with it
+    const ErrorRecord* visitNumberNode(const spNode& node, const spContext& context);
+    const ErrorRecord* visitConstantNode(const spNode& node, const spContext& context);
+    const ErrorRecord* checkVariableDeclarationNode(const spNode& node, const spContext& context);
+    const ErrorRecord* visitVariableDeclarationNode(const spNode& node, const spContext& context);
+    const ErrorRecord* visitVariableAssignmentNode(const spNode& node, const spContext& context);
+    const ErrorRecord* visitVariableRetrievementNode(const spNode& node, const spContext& context);
+    template<bool Profiled> const ErrorRecord* visitBinaryOperatorNode(const spNode& node, const spContext& context);
+    template<bool Profiled> const ErrorRecord* visitUnaryOperatorNode(const spNode& node, const spContext& context);
+
+    const ErrorRecord* setVariable(const spNode& node, const spContext& context, const Value& value, const bool& declaration);
+
+private:
+    // A node to evaluate, or one whose children were evaluated and only the node itself is left
+    struct Pending {
+        const spNode* node;
+        bool childrenVisited;
+    };
+    // Kept so their capacity carries over from one statement to the next
+    std::vector<Pending> pending;
+    // The results of the nodes evaluated so far that their parents haven't used yet
+    std::vector<Value> values;
 };
 
 #endif // !INTERPRETER_H
@@ -0,0 +1,42 @@
+#pragma once
+#ifndef QUICKENING_H
+#define QUICKENING_H
+#include <cstdint>
+#include "../object/object.h"
+
+enum class QuickeningState : uint8_t {
+    // The operator hasn't been looked up from the node's token yet
+    Unresolved,
+    // Runs the generic operator and counts how many evaluations in a row had operands of the same types
+    Warming,
+    // Runs the operator specialized for the left and right types, as long as a guard finds the operands still have them
+    Specialized,
+    // Deoptimized too often, only the generic operator runs from now on
+    Generic,
+};
+
+// What an operator node has rewritten itself into, only ever read and written by the Interpreter evaluating it
+struct Quickening {
+    QuickeningState state = QuickeningState::Unresolved;
+    // Index into the Interpreter's operator tables, -1 for a token that isn't an operator the Interpreter knows
+    int8_t operation = -1;
+    // The types seen while warming, and then the ones the node is specialized for (right is unused on a unary node)
+    ValueType left = ValueType::Null;
+    ValueType right = ValueType::Null;
+    uint8_t warmups = 0;
+    uint8_t deoptimizations = 0;
+};
+
+// Counted by the Interpreter while Interpreter::quickeningStats is set
+struct QuickeningStats {
+    // Nodes that rewrote themselves into a specialized operator
+    unsigned long long specializations = 0;
+    // Evaluations a specialized operator did
+    unsigned long long hits = 0;
+    // Evaluations whose operands failed the guard, each one deoptimizes its node back to the generic operator
+    unsigned long long misses = 0;
+    // Evaluations the generic operator did
+    unsigned long long generic = 0;
+};
+
+#endif // !QUICKENING_H
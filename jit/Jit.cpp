@@ -0,0 +1,509 @@
+#include "jit.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+#include "../object/operations.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define JIT_X86_64
+#endif
+
+// A subtree that needs more of these than this to keep left sides around while right sides run is left to
+// the Interpreter, so the native frame stays small
+const int maximumSpills = 256;
+const std::size_t chunkSize = 64 * 1024;
+
+struct JitChunk {
+    unsigned char* memory = nullptr;
+    std::size_t size = 0;
+    std::size_t used = 0;
+
+    JitChunk(const std::size_t& size) {
+#ifdef _WIN32
+        memory = static_cast<unsigned char*>(VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE, PAGE_READONLY));
+#else
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        memory = mapping == MAP_FAILED ? nullptr : static_cast<unsigned char*>(mapping);
+#endif
+        if (memory != nullptr) this->size = size;
+    }
+
+    ~JitChunk() {
+        if (memory == nullptr) return;
+#ifdef _WIN32
+        VirtualFree(memory, 0, MEM_RELEASE);
+#else
+        munmap(memory, size);
+#endif
+    }
+
+    JitChunk(const JitChunk&) = delete;
+    JitChunk& operator=(const JitChunk&) = delete;
+
+    // The pages are never writable and executable at the same time
+    bool write(const std::vector<unsigned char>& code) {
+#ifdef _WIN32
+        DWORD previous;
+        if (!VirtualProtect(memory, size, PAGE_READWRITE, &previous)) return false;
+        std::memcpy(memory + used, code.data(), code.size());
+        if (!VirtualProtect(memory, size, PAGE_EXECUTE_READ, &previous)) return false;
+        FlushInstructionCache(GetCurrentProcess(), memory + used, code.size());
+#else
+        if (mprotect(memory, size, PROT_READ | PROT_WRITE) != 0) return false;
+        std::memcpy(memory + used, code.data(), code.size());
+        if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) return false;
+#endif
+        return true;
+    }
+};
+
+bool jitSupported() {
+#ifdef JIT_X86_64
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool JitFunction::run(const spContext& context, Value& result) const {
+    // Nearly every subtree reads only a few variables, so the inputs only need the heap for big ones
+    double fixedInputs[32];
+    std::vector<double> heapInputs;
+    double* inputs = fixedInputs;
+    if (variables.size() > 32) {
+        heapInputs.resize(variables.size());
+        inputs = heapInputs.data();
+    }
+    for (std::size_t i = 0; i < variables.size(); i++) {
+        const Node* variable = variables[i];
+        // Resolved again before every run, a variable that has no slot this time is looked up by the Interpreter
+        if (variable->slot == -1) return false;
+        const Value* value = context->symbolTable->ancestor(variable->depth)->getSlot(variable->slot);
+        if (value == nullptr) return false;
+        if (value->type == ValueType::Boolean) {
+            inputs[i] = value->doubleValue;
+            continue;
+        }
+        // Only finite Numbers that look the way Number() makes them, Infinity and NaN are flags the code doesn't have
+        if (value->type != ValueType::Number || !value->isPureDouble || value->isInfinity || value->isNaN) return false;
+        double number = value->doubleValue;
+        if (!std::isfinite(number) || value->sign != !(number < 0) || value->isPureZero != (number == 0)) return false;
+        inputs[i] = number;
+    }
+
+    double output;
+    if (entry(inputs, &output) == 0) return false;
+    result = returnsBoolean ? Boolean(output != 0) : Number(output);
+    return true;
+}
+
+namespace {
+    // What pow and floor are called through, so the code doesn't depend on which overload the headers pick
+    double jitPow(double base, double exponent) {
+        return std::pow(base, exponent);
+    }
+
+    double jitFloor(double value) {
+        return std::floor(value);
+    }
+
+    enum class JitOperation {
+        None,
+        Add,
+        Subtract,
+        Multiply,
+        Divide,
+        Power,
+        FlooredDivide,
+        Equal,
+        NotEqual,
+        LessThan,
+        LessThanEqual,
+        GreaterThan,
+        GreaterThanEqual,
+        Plus,
+        Minus,
+        Not,
+    };
+
+    // Add to GreaterThanEqual and Plus to Not are in the same order as BinaryOperator and UnaryOperator
+    static_assert((int) JitOperation::GreaterThanEqual - (int) JitOperation::Add == (int) BinaryOperator::GreaterThanEqual, "JitOperation and BinaryOperator are out of order");
+    static_assert((int) JitOperation::Not - (int) JitOperation::Plus == (int) UnaryOperator::Bang, "JitOperation and UnaryOperator are out of order");
+
+    JitOperation binaryOperation(const Node& node) {
+        BinaryOperator op = binaryOperatorFor(node.token.kind);
+        if (op == BinaryOperator::COUNT) return JitOperation::None;
+        return (JitOperation) ((int) JitOperation::Add + (int) op);
+    }
+
+    JitOperation unaryOperation(const Node& node) {
+        UnaryOperator op = unaryOperatorFor(node.token.kind);
+        if (op == UnaryOperator::COUNT) return JitOperation::None;
+        return (JitOperation) ((int) JitOperation::Plus + (int) op);
+    }
+
+    JitOperation operationOf(const Node& node) {
+        if (node.kind == NodeKind::BinaryOperator) return binaryOperation(node);
+        if (node.kind == NodeKind::UnaryOperator) return unaryOperation(node);
+        return JitOperation::None;
+    }
+
+    bool isComparison(const JitOperation& operation) {
+        return operation >= JitOperation::Equal && operation <= JitOperation::GreaterThanEqual;
+    }
+
+    // A leaf the code can hold as a double, constant is set for everything but variables
+    bool leafValue(const Node& node, bool& constant, double& value) {
+        constant = true;
+        if (node.kind == NodeKind::Number) {
+            Value number = Number(node.token.value);
+            value = number.doubleValue;
+            return number.isPureDouble && std::isfinite(value);
+        } else if (node.kind == NodeKind::Constant) {
+            const Value& constantValue = node.value;
+            value = constantValue.doubleValue;
+            if (constantValue.type == ValueType::Boolean) return true;
+            return constantValue.type == ValueType::Number && constantValue.isPureDouble && !constantValue.isInfinity && !constantValue.isNaN && std::isfinite(value);
+        } else if (node.kind == NodeKind::VariableRetrievement) {
+            constant = false;
+            return true;
+        }
+        return false;
+    }
+
+    bool isLeaf(const Node& node) {
+        bool constant;
+        double value;
+        return leafValue(node, constant, value);
+    }
+
+    // Walks every node once, children before parents
+    template<class Visit>
+    void postOrder(const spNode& root, Visit visit) {
+        std::vector<std::pair<const Node*, bool>> stack = { { root.get(), false } };
+        while (!stack.empty()) {
+            std::pair<const Node*, bool> top = stack.back();
+            stack.pop_back();
+            if (top.second) {
+                visit(*top.first);
+                continue;
+            }
+            stack.push_back({ top.first, true });
+            if (top.first->rightNode != nullptr) stack.push_back({ top.first->rightNode.get(), false });
+            if (top.first->leftNode != nullptr) stack.push_back({ top.first->leftNode.get(), false });
+        }
+    }
+
+#ifdef JIT_X86_64
+    // Native code for one subtree, it keeps whatever it has computed last in xmm0
+    // rbx points at the inputs and r12 at the result, both are saved on entry since they're callee-saved everywhere
+    struct Assembler {
+        std::vector<unsigned char> code;
+        // Where each rel32 that jumps to the bail out block is
+        std::vector<std::size_t> bailFixups;
+        std::size_t frameSizeOffset = 0;
+
+        void bytes(std::initializer_list<unsigned char> values) {
+            code.insert(code.end(), values);
+        }
+
+        void int32(const int32_t& value) {
+            for (int i = 0; i < 4; i++) code.push_back((unsigned char) ((uint32_t) value >> (8 * i)));
+        }
+
+        void int64(const uint64_t& value) {
+            for (int i = 0; i < 8; i++) code.push_back((unsigned char) (value >> (8 * i)));
+        }
+
+        void prologue() {
+            // push rbx, push r12, sub rsp, imm32 (patched once the frame size is known)
+            bytes({ 0x53, 0x41, 0x54, 0x48, 0x81, 0xEC });
+            frameSizeOffset = code.size();
+            int32(0);
+#ifdef _WIN32
+            // mov rbx, rcx, mov r12, rdx
+            bytes({ 0x48, 0x89, 0xCB, 0x49, 0x89, 0xD4 });
+#else
+            // mov rbx, rdi, mov r12, rsi
+            bytes({ 0x48, 0x89, 0xFB, 0x49, 0x89, 0xF4 });
+#endif
+        }
+
+        void epilogue(const int& spills) {
+            // 32 bytes of shadow space for the calls on Windows, then the spills, and 8 more if that leaves rsp
+            // off a 16 byte boundary (the return address and two pushes are 24 bytes)
+            int32_t frameSize = 32 + 8 * spills;
+            if (frameSize % 16 == 0) frameSize += 8;
+            std::memcpy(&code[frameSizeOffset], &frameSize, 4);
+            // movsd [r12], xmm0, mov eax, 1, jmp over the bail out block
+            bytes({ 0xF2, 0x41, 0x0F, 0x11, 0x04, 0x24, 0xB8, 0x01, 0x00, 0x00, 0x00, 0xEB, 0x02 });
+            std::size_t bail = code.size();
+            for (const std::size_t& fixup : bailFixups) {
+                int32_t offset = (int32_t) (bail - (fixup + 4));
+                std::memcpy(&code[fixup], &offset, 4);
+            }
+            // xor eax, eax, add rsp, imm32, pop r12, pop rbx, ret
+            bytes({ 0x31, 0xC0, 0x48, 0x81, 0xC4 });
+            int32(frameSize);
+            bytes({ 0x41, 0x5C, 0x5B, 0xC3 });
+        }
+
+        // je bail
+        void bailIfEqual() {
+            bytes({ 0x0F, 0x84 });
+            bailFixups.push_back(code.size());
+            int32(0);
+        }
+
+        // Every result the Interpreter would turn into Infinity or NaN is left to it, by checking the exponent bits
+        void bailIfNotFinite() {
+            // movq rax, xmm0, shr rax, 52, and eax, 0x7FF, cmp eax, 0x7FF
+            bytes({ 0x66, 0x48, 0x0F, 0x7E, 0xC0, 0x48, 0xC1, 0xE8, 0x34, 0x25, 0xFF, 0x07, 0x00, 0x00, 0x3D, 0xFF, 0x07, 0x00, 0x00 });
+            bailIfEqual();
+        }
+
+        // xmm is 0 or 1
+        void loadConstant(const int& xmm, const double& value) {
+            uint64_t bits;
+            std::memcpy(&bits, &value, 8);
+            // mov rax, imm64, movq xmm, rax
+            bytes({ 0x48, 0xB8 });
+            int64(bits);
+            bytes({ 0x66, 0x48, 0x0F, 0x6E, (unsigned char) (0xC0 | (xmm << 3)) });
+        }
+
+        void loadInput(const int& xmm, const int& index) {
+            // movsd xmm, [rbx + disp32]
+            bytes({ 0xF2, 0x0F, 0x10, (unsigned char) (0x83 | (xmm << 3)) });
+            int32(8 * index);
+        }
+
+        void spill(const int& slot) {
+            // movsd [rsp + disp32], xmm0
+            bytes({ 0xF2, 0x0F, 0x11, 0x84, 0x24 });
+            int32(32 + 8 * slot);
+        }
+
+        void reload(const int& slot) {
+            // movsd xmm1, xmm0, movsd xmm0, [rsp + disp32]
+            bytes({ 0xF2, 0x0F, 0x10, 0xC8, 0xF2, 0x0F, 0x10, 0x84, 0x24 });
+            int32(32 + 8 * slot);
+        }
+
+        void call(const void* function) {
+            // mov rax, imm64, call rax
+            bytes({ 0x48, 0xB8 });
+            int64((uint64_t) (uintptr_t) function);
+            bytes({ 0xFF, 0xD0 });
+        }
+
+        // xmm0 = xmm0 op xmm1
+        void binary(const JitOperation& operation) {
+            switch (operation) {
+                case JitOperation::Add: bytes({ 0xF2, 0x0F, 0x58, 0xC1 }); bailIfNotFinite(); break;
+                case JitOperation::Subtract: bytes({ 0xF2, 0x0F, 0x5C, 0xC1 }); bailIfNotFinite(); break;
+                case JitOperation::Multiply: bytes({ 0xF2, 0x0F, 0x59, 0xC1 }); bailIfNotFinite(); break;
+                case JitOperation::Divide:
+                case JitOperation::FlooredDivide:
+                {
+                    // Dividing by 0 is an error the Interpreter reports, xorpd xmm2, xmm2, ucomisd xmm1, xmm2
+                    bytes({ 0x66, 0x0F, 0x57, 0xD2, 0x66, 0x0F, 0x2E, 0xCA });
+                    bailIfEqual();
+                    bytes({ 0xF2, 0x0F, 0x5E, 0xC1 });
+                    bailIfNotFinite();
+                    if (operation == JitOperation::FlooredDivide) call((const void*) &jitFloor);
+                    break;
+                }
+                case JitOperation::Power:
+                {
+                    call((const void*) &jitPow);
+                    bailIfNotFinite();
+                    break;
+                }
+                default:
+                {
+                    unsigned char condition = 0;
+                    switch (operation) {
+                        case JitOperation::Equal: condition = 0x94; break;
+                        case JitOperation::NotEqual: condition = 0x95; break;
+                        case JitOperation::LessThan: condition = 0x92; break;
+                        case JitOperation::LessThanEqual: condition = 0x96; break;
+                        case JitOperation::GreaterThan: condition = 0x97; break;
+                        default: condition = 0x93; break;
+                    }
+                    // xor eax, eax, ucomisd xmm0, xmm1, setcc al, cvtsi2sd xmm0, eax
+                    bytes({ 0x31, 0xC0, 0x66, 0x0F, 0x2E, 0xC1, 0x0F, condition, 0xC0, 0xF2, 0x0F, 0x2A, 0xC0 });
+                    break;
+                }
+            }
+        }
+
+        // xmm0 = op xmm0
+        void unary(const JitOperation& operation) {
+            if (operation == JitOperation::Minus) {
+                // Flipping the sign bit is what multiplying by -1 does to a finite double, 0 included
+                loadConstant(1, -0.0);
+                // xorpd xmm0, xmm1
+                bytes({ 0x66, 0x0F, 0x57, 0xC1 });
+            } else if (operation == JitOperation::Not) {
+                // xorpd xmm1, xmm1, xor eax, eax, ucomisd xmm0, xmm1, sete al, cvtsi2sd xmm0, eax
+                bytes({ 0x66, 0x0F, 0x57, 0xC9, 0x31, 0xC0, 0x66, 0x0F, 0x2E, 0xC1, 0x0F, 0x94, 0xC0, 0xF2, 0x0F, 0x2A, 0xC0 });
+            }
+            // A unary + only turns a Boolean into a Number, which the code doesn't tell apart
+        }
+    };
+#endif
+}
+
+JitCompiler::JitCompiler() {}
+
+JitCompiler::~JitCompiler() {}
+
+void JitCompiler::prepare(const spNode& statement) {
+    statement->jitPrepared = true;
+#ifdef JIT_X86_64
+    // Which nodes only need what the code can do, and how many spills running each of them takes
+    std::unordered_map<const Node*, int> spills;
+    postOrder(statement, [&](const Node& node) {
+        if (isLeaf(node)) {
+            spills[&node] = 0;
+            return;
+        }
+        JitOperation operation = operationOf(node);
+        if (operation == JitOperation::None) return;
+        if (node.kind == NodeKind::UnaryOperator) {
+            auto child = spills.find(node.rightNode.get());
+            if (child != spills.end()) spills[&node] = child->second;
+            return;
+        }
+        auto left = spills.find(node.leftNode.get());
+        auto right = spills.find(node.rightNode.get());
+        if (left == spills.end() || right == spills.end()) return;
+        // A leaf on the right is loaded straight into xmm1, anything else runs while the left side waits in a spill
+        int needed = isLeaf(*node.rightNode) ? left->second : std::max(left->second, right->second + 1);
+        spills[&node] = needed;
+    });
+
+    // The largest subtrees that can run natively get a function, everything above them is left as is
+    std::vector<Node*> stack = { statement.get() };
+    while (!stack.empty()) {
+        Node* node = stack.back();
+        stack.pop_back();
+        auto found = spills.find(node);
+        if (found != spills.end() && found->second <= maximumSpills && operationOf(*node) != JitOperation::None) {
+            node->jitFunction = compile(*node);
+            if (node->jitFunction != nullptr) {
+                compiledFunctions++;
+                continue;
+            }
+        }
+        for (const spNode* child : { &node->leftNode, &node->rightNode, &node->valueNode }) {
+            if (*child != nullptr) stack.push_back(child->get());
+        }
+        for (const spNode& child : node->statementNodes) stack.push_back(child.get());
+    }
+#endif
+}
+
+std::shared_ptr<JitFunction> JitCompiler::compile(const Node& root) {
+#ifdef JIT_X86_64
+    std::shared_ptr<JitFunction> function = std::make_shared<JitFunction>();
+    JitOperation rootOperation = operationOf(root);
+    function->returnsBoolean = isComparison(rootOperation) || rootOperation == JitOperation::Not;
+
+    Assembler assembler;
+    assembler.prologue();
+
+    auto loadLeaf = [&](const Node& leaf, const int& xmm) {
+        bool constant;
+        double value;
+        leafValue(leaf, constant, value);
+        if (constant) {
+            assembler.loadConstant(xmm, value);
+        } else {
+            assembler.loadInput(xmm, (int) function->variables.size());
+            function->variables.push_back(&leaf);
+        }
+    };
+
+    // Operands in the order the Interpreter visits them, 0 is on the way down, 1 after the left side and 2 after
+    // the right side
+    struct Frame {
+        const Node* node;
+        int state;
+    };
+    std::vector<Frame> frames = { { &root, 0 } };
+    int depth = 0;
+    int maximumDepth = 0;
+    while (!frames.empty()) {
+        Frame& frame = frames.back();
+        const Node& node = *frame.node;
+        if (frame.state == 0 && isLeaf(node)) {
+            loadLeaf(node, 0);
+            frames.pop_back();
+            continue;
+        }
+        JitOperation operation = operationOf(node);
+        if (node.kind == NodeKind::UnaryOperator) {
+            if (frame.state == 0) {
+                frame.state = 1;
+                frames.push_back({ node.rightNode.get(), 0 });
+            } else {
+                assembler.unary(operation);
+                frames.pop_back();
+            }
+            continue;
+        }
+        if (frame.state == 0) {
+            frame.state = 1;
+            frames.push_back({ node.leftNode.get(), 0 });
+        } else if (frame.state == 1) {
+            if (isLeaf(*node.rightNode)) {
+                loadLeaf(*node.rightNode, 1);
+                assembler.binary(operation);
+                frames.pop_back();
+            } else {
+                frame.state = 2;
+                assembler.spill(depth++);
+                maximumDepth = std::max(maximumDepth, depth);
+                frames.push_back({ node.rightNode.get(), 0 });
+            }
+        } else {
+            assembler.reload(--depth);
+            assembler.binary(operation);
+            frames.pop_back();
+        }
+    }
+    assembler.epilogue(maximumDepth);
+
+    function->entry = install(assembler.code);
+    if (function->entry == nullptr) return nullptr;
+    function->chunk = chunk;
+    return function;
+#else
+    return nullptr;
+#endif
+}
+
+JitFunction::Entry JitCompiler::install(const std::vector<unsigned char>& code) {
+    if (chunk == nullptr || chunk->used + code.size() > chunk->size) {
+        chunk = std::make_shared<JitChunk>(std::max(chunkSize, code.size()));
+        if (chunk->memory == nullptr) {
+            chunk = nullptr;
+            return nullptr;
+        }
+    }
+    if (!chunk->write(code)) return nullptr;
+    JitFunction::Entry entry = reinterpret_cast<JitFunction::Entry>(chunk->memory + chunk->used);
+    // Each function starts on its own 16 bytes
+    chunk->used = std::min(chunk->size, (chunk->used + code.size() + 15) & ~(std::size_t) 15);
+    return entry;
+}
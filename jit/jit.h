@@ -0,0 +1,55 @@
+#pragma once
+#ifndef JIT_H
+#define JIT_H
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "../ast/ast.h"
+#include "../context/context.h"
+#include "../object/object.h"
+
+// Executable memory that JitFunctions are written into, only ever writable while the JitCompiler that owns it is
+// writing into it
+struct JitChunk;
+
+// Native code for a subtree that only does + - * / ** // comparisons and unary operators on numbers
+// The code works on plain doubles and bails out whenever a result wouldn't be a finite double (Infinity, NaN,
+// overflow) or an operation would fail (division by 0), and the Interpreter then evaluates the subtree itself,
+// so it never has to know about the flags a Value keeps
+struct JitFunction {
+    // Returns 0 when it bailed out
+    typedef int (*Entry)(const double* inputs, double* result);
+
+    Entry entry = nullptr;
+    std::shared_ptr<JitChunk> chunk;
+    // The variable nodes the code reads, each one's value is passed in inputs in this order
+    std::vector<const Node*> variables;
+    // Comparisons and ! give a Boolean, everything else gives a Number
+    bool returnsBoolean = false;
+
+    // False when it bailed out, result is only set on success
+    bool run(const spContext& context, Value& result) const;
+};
+
+// Whether this build can make native code, only x86-64 can
+bool jitSupported();
+
+// Every Runner (and so every thread) has its own, so the chunks it writes into are only ever run by that thread
+struct JitCompiler {
+    std::size_t compiledFunctions = 0;
+
+    JitCompiler();
+    ~JitCompiler();
+
+    // Gives every largest subtree of a resolved statement that the JIT can run a JitFunction, once per statement
+    // Variables have to be resolved to a slot to be used
+    void prepare(const spNode& statement);
+
+private:
+    std::shared_ptr<JitChunk> chunk;
+
+    std::shared_ptr<JitFunction> compile(const Node& root);
+    JitFunction::Entry install(const std::vector<unsigned char>& code);
+};
+
+#endif // !JIT_H
@@ -3,21 +3,26 @@
 #include <memory>
 #include "../token/tokens.h"
 #include "../position/position.h"
+#include "../source/source.h"
 #include "../error/error.h"
 #include "../reservedwords/reservedwords.h"
+#include "scan.h"
 
-Lexer::Lexer(const std::string& input, const std::string&& filename) {
-    this->input = input;
-    this->inputLength = input.length();
+Lexer::Lexer(const std::string& input, const std::string&& filename) : Lexer(registerSourceFile(filename, input)) {}
+
+Lexer::Lexer(const int& fileId) {
+    this->input = getSourceFile(fileId).text;
+    this->inputLength = this->input.length();
     if (inputLength > 0) {
         this->current = input[0];
     } else {
         this->current = 0;
     }
 
-    this->position = Position(-1, 0, -1, filename, input);
+    this->position = Position(fileId, -1);
     this->position.advance();
     this->finished = false;
+    this->validUtf8Length = validateUtf8(input.data(), inputLength);
 }
 
 void Lexer::readChar() {
@@ -29,6 +34,15 @@ void Lexer::readChar() {
     position.advance();
 }
 
+void Lexer::jumpTo(const int& index) {
+    if (index >= inputLength) {
+        current = 0;
+    } else {
+        current = input[index];
+    }
+    position.index = index;
+}
+
 char Lexer::peekChar(const int& num) const {
     if (position.index + num + 1 >= inputLength) {
         return 0;
@@ -43,12 +57,12 @@ reset:
     switch (current) {
         case '+':
         {
-            token = Token(tokens::PLUS, "+", position, position);
+            token = Token(TokenKind::PLUS, "+", position, position);
             break;
         }
         case '-':
         {
-            token = Token(tokens::MINUS, "-", position, position);
+            token = Token(TokenKind::MINUS, "-", position, position);
             break;
         }
         case '*':
@@ -56,10 +70,10 @@ reset:
             if (peekChar() == '*') {
                 Position start = position;
                 readChar();
-                token = Token(tokens::DOUBLE_ASTERISK, "**", start, position);
+                token = Token(TokenKind::DOUBLE_ASTERISK, "**", start, position);
                 break;
             }
-            token = Token(tokens::ASTERISK, "*", position, position);
+            token = Token(TokenKind::ASTERISK, "*", position, position);
             break;
         }
         case '/':
@@ -67,20 +81,20 @@ reset:
             if (peekChar() == '/') {
                 Position start = position;
                 readChar();
-                token = Token(tokens::DOUBLE_F_SLASH, "//", start, position);
+                token = Token(TokenKind::DOUBLE_F_SLASH, "//", start, position);
                 break;
             }
-            token = Token(tokens::F_SLASH, "/", position, position);
+            token = Token(TokenKind::F_SLASH, "/", position, position);
             break;
         }
         case '(':
         {
-            token = Token(tokens::OPEN_PAREN, "(", position, position);
+            token = Token(TokenKind::OPEN_PAREN, "(", position, position);
             break;
         }
         case ')':
         {
-            token = Token(tokens::CLOSE_PAREN, ")", position, position);
+            token = Token(TokenKind::CLOSE_PAREN, ")", position, position);
             break;
         }
         case '=':
@@ -88,10 +102,10 @@ reset:
             if (peekChar() == '=') {
                 Position start = position;
                 readChar();
-                token = Token(tokens::DOUBLE_EQUAL, "==", start, position);
+                token = Token(TokenKind::DOUBLE_EQUAL, "==", start, position);
                 break;
             }
-            token = Token(tokens::EQUAL, "=", position, position);
+            token = Token(TokenKind::EQUAL, "=", position, position);
             break;
         }
         case '!':
@@ -99,10 +113,10 @@ reset:
             if (peekChar() == '=') {
                 Position start = position;
                 readChar();
-                token = Token(tokens::BANG_EQUAL, "!=", start, position);
+                token = Token(TokenKind::BANG_EQUAL, "!=", start, position);
                 break;
             }
-            token = Token(tokens::BANG, "!", position, position);
+            token = Token(TokenKind::BANG, "!", position, position);
             break;
         }
         case '<':
@@ -110,10 +124,10 @@ reset:
             if (peekChar() == '=') {
                 Position start = position;
                 readChar();
-                token = Token(tokens::LESS_THAN_EQUAL, "<=", start, position);
+                token = Token(TokenKind::LESS_THAN_EQUAL, "<=", start, position);
                 break;
             }
-            token = Token(tokens::LESS_THAN, "<", position, position);
+            token = Token(TokenKind::LESS_THAN, "<", position, position);
             break;
         }
         case '>':
@@ -121,51 +135,69 @@ reset:
             if (peekChar() == '=') {
                 Position start = position;
                 readChar();
-                token = Token(tokens::GREATER_THAN_EQUAL, ">=", start, position);
+                token = Token(TokenKind::GREATER_THAN_EQUAL, ">=", start, position);
                 break;
             }
-            token = Token(tokens::GREATER_THAN, ">", position, position);
+            token = Token(TokenKind::GREATER_THAN, ">", position, position);
+            break;
+        }
+        case ';':
+        {
+            token = Token(TokenKind::SEMICOLON, ";", position, position);
+            break;
+        }
+        case '\n':
+        {
+            token = Token(TokenKind::NEWLINE, "\\n", position, position);
             break;
         }
         case ' ':
+        case '\t':
+        case '\r':
         {
-            readChar();
+            jumpTo(scanWhitespace(input.data(), position.index, inputLength));
             goto reset;
         }
         case '\0':
         {
             finished = true;
-            return Token(tokens::EEOF, "", position, position);
+            return Token(TokenKind::EEOF, "", position, position);
         }
         default:
         {
             if (isNumeric(current)) {
-                std::string value = std::string(1, current);
                 Position positionStart = position;
-                bool period = false;
-                while (isNumeric(peekChar()) || (peekChar() == '.' && !period)) {
-                    value += peekChar();
-                    if (peekChar() == '.') {
-                        period = true;
-                    }
-                    readChar();
+                // Digits, then at most one period followed by more digits
+                int end = scanDigits(input.data(), position.index + 1, inputLength);
+                if (end < inputLength && input[end] == '.') {
+                    end = scanDigits(input.data(), end + 1, inputLength);
                 }
-                token = Token(tokens::NUMBER, value, positionStart, position);
+                jumpTo(end - 1);
+                std::string_view value = input.substr(positionStart.index, position.index - positionStart.index + 1);
+                token = Token(TokenKind::NUMBER, value, positionStart, position);
                 break;
             } else if (isIdentifierStarter(current)) {
-                std::string value = std::string(1, current);
                 Position positionStart = position;
-                while (isIdentifierCharacter(peekChar())) {
-                    value += peekChar();
+                jumpTo(scanIdentifier(input.data(), position.index + 1, inputLength) - 1);
+                std::string_view value = input.substr(positionStart.index, position.index - positionStart.index + 1);
+                token = Token(isReservedWord(value) ? TokenKind::KEYWORD : TokenKind::IDENTIFIER, value, positionStart, position);
+                break;
+            } else if ((unsigned char) current >= 0x80) {
+                // No token can contain anything past ASCII, so this only decides how the error shows it
+                Position positionStart = position;
+                if (position.index >= validUtf8Length) {
+                    int byte = (unsigned char) current;
                     readChar();
+                    return keepErrorRecord(ErrorRecord(ErrorKind::IllegalChar, MessageId::InvalidUtf8Byte, positionStart, position).withNumber(byte));
                 }
-                token = Token(isReservedWord(value) ? tokens::KEYWORD : tokens::IDENTIFIER, value, positionStart, position);
-                break;
+                std::string_view character = input.substr(position.index, utf8SequenceLength((unsigned char) current));
+                jumpTo(position.index + character.size());
+                return keepErrorRecord(ErrorRecord(ErrorKind::IllegalChar, MessageId::IllegalCharacter, positionStart, position).with(character));
             } else {
                 Position positionStart = position;
-                char tempCurrent = current;
+                std::string_view character = input.substr(position.index, 1);
                 readChar();
-                return (spError) IllegalCharError(positionStart, position, std::string(1, '\'') + tempCurrent + "'");
+                return keepErrorRecord(ErrorRecord(ErrorKind::IllegalChar, MessageId::IllegalCharacter, positionStart, position).with(character));
             }
         }
     }
@@ -194,7 +226,7 @@ bool Lexer::isIdentifierCharacter(const char& c) const {
 }
 
 MultiLexResult Lexer::tokenize() {
-    std::vector<Token> tokenized;
+    TokenList tokenized;
     while (!finished) {
         SingleLexResult slr = nextToken();
         if (slr.error) {
@@ -202,5 +234,5 @@ MultiLexResult Lexer::tokenize() {
         }
         tokenized.push_back(slr.token);
     }
-    return tokenized;
+    return std::move(tokenized);
 }
@@ -0,0 +1,184 @@
+#include "scan.h"
+#include <cstdint>
+
+#if !defined(BARKSCRIPT_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define SCAN_SSE2
+#include <emmintrin.h>
+#endif
+
+// AVX2 is only picked at runtime, the build itself doesn't assume it
+#if defined(SCAN_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SCAN_AVX2
+#include <immintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+    bool isWhitespaceByte(const char& c) {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    bool isDigitByte(const char& c) {
+        return '0' <= c && c <= '9';
+    }
+
+    bool isIdentifierByte(const char& c) {
+        return ('A' <= c && c <= 'Z') || ('a' <= c && c <= 'z') || c == '_' || isDigitByte(c);
+    }
+
+#ifdef SCAN_SSE2
+    int firstSetBit(const unsigned int& mask) {
+#ifdef _MSC_VER
+        unsigned long bit;
+        _BitScanForward(&bit, mask);
+        return (int) bit;
+#else
+        return __builtin_ctz(mask);
+#endif
+    }
+
+    // Each returns a mask with bit i set when byte i of chunk belongs to the run
+    // Bytes from 0x80 up compare as negative, so they never fall into any of the ranges
+
+    unsigned int whitespaceMask(const __m128i& chunk) {
+        __m128i space = _mm_cmpeq_epi8(chunk, _mm_set1_epi8(' '));
+        __m128i tab = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'));
+        __m128i carriageReturn = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r'));
+        return _mm_movemask_epi8(_mm_or_si128(space, _mm_or_si128(tab, carriageReturn)));
+    }
+
+    __m128i digitBytes(const __m128i& chunk) {
+        return _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(chunk, _mm_set1_epi8('9' + 1)));
+    }
+
+    unsigned int digitMask(const __m128i& chunk) {
+        return _mm_movemask_epi8(digitBytes(chunk));
+    }
+
+    unsigned int identifierMask(const __m128i& chunk) {
+        // Setting 0x20 folds A-Z onto a-z without folding anything else onto a-z
+        __m128i lower = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+        __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+        __m128i underscore = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('_'));
+        return _mm_movemask_epi8(_mm_or_si128(alpha, _mm_or_si128(underscore, digitBytes(chunk))));
+    }
+
+    template<unsigned int(*mask)(const __m128i&)>
+    size_t scanRun(const char* text, size_t index, const size_t& length) {
+        while (index + 16 <= length) {
+            unsigned int outside = ~mask(_mm_loadu_si128((const __m128i*) (text + index))) & 0xFFFF;
+            if (outside != 0) return index + firstSetBit(outside);
+            index += 16;
+        }
+        return index;
+    }
+#endif
+}
+
+size_t scanWhitespace(const char* text, size_t index, const size_t& length) {
+#ifdef SCAN_SSE2
+    // Most runs end on their first byte, those never need a vector load
+    if (index >= length || !isWhitespaceByte(text[index])) return index;
+    index = scanRun<whitespaceMask>(text, index, length);
+#endif
+    while (index < length && isWhitespaceByte(text[index])) index++;
+    return index;
+}
+
+size_t scanDigits(const char* text, size_t index, const size_t& length) {
+#ifdef SCAN_SSE2
+    // Most runs end on their first byte, those never need a vector load
+    if (index >= length || !isDigitByte(text[index])) return index;
+    index = scanRun<digitMask>(text, index, length);
+#endif
+    while (index < length && isDigitByte(text[index])) index++;
+    return index;
+}
+
+size_t scanIdentifier(const char* text, size_t index, const size_t& length) {
+#ifdef SCAN_SSE2
+    // Most runs end on their first byte, those never need a vector load
+    if (index >= length || !isIdentifierByte(text[index])) return index;
+    index = scanRun<identifierMask>(text, index, length);
+#endif
+    while (index < length && isIdentifierByte(text[index])) index++;
+    return index;
+}
+
+int utf8SequenceLength(const unsigned char& lead) {
+    if (lead < 0x80) return 1;
+    if (lead < 0xC2) return 0; // continuation bytes and overlong 2 byte leads
+    if (lead < 0xE0) return 2;
+    if (lead < 0xF0) return 3;
+    if (lead < 0xF5) return 4;
+    return 0;
+}
+
+namespace {
+    // Length of the valid sequence at index, 0 if it isn't valid
+    size_t validateUtf8Sequence(const unsigned char* bytes, const size_t& index, const size_t& length) {
+        unsigned char lead = bytes[index];
+        int sequenceLength = utf8SequenceLength(lead);
+        if (sequenceLength <= 1 || index + sequenceLength > length) return sequenceLength == 1 ? 1 : 0;
+        // The second byte has a narrower range after some leads, that rules out overlongs, surrogates and past U+10FFFF
+        unsigned char low = 0x80;
+        unsigned char high = 0xBF;
+        if (lead == 0xE0) low = 0xA0;
+        else if (lead == 0xED) high = 0x9F;
+        else if (lead == 0xF0) low = 0x90;
+        else if (lead == 0xF4) high = 0x8F;
+        if (bytes[index + 1] < low || bytes[index + 1] > high) return 0;
+        for (int i = 2; i < sequenceLength; i++) {
+            if ((bytes[index + i] & 0xC0) != 0x80) return 0;
+        }
+        return sequenceLength;
+    }
+
+#ifdef SCAN_AVX2
+    __attribute__((target("avx2")))
+    size_t skipAsciiAVX2(const char* text, size_t index, const size_t& length) {
+        while (index + 32 <= length) {
+            unsigned int high = _mm256_movemask_epi8(_mm256_loadu_si256((const __m256i*) (text + index)));
+            if (high != 0) return index + __builtin_ctz(high);
+            index += 32;
+        }
+        return index;
+    }
+
+    const bool hasAVX2 = []() {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+    }();
+#endif
+
+    // Skips to the first byte with the high bit set
+    size_t skipAscii(const char* text, size_t index, const size_t& length) {
+#ifdef SCAN_AVX2
+        if (hasAVX2) index = skipAsciiAVX2(text, index, length);
+#endif
+#ifdef SCAN_SSE2
+        while (index + 16 <= length) {
+            unsigned int high = _mm_movemask_epi8(_mm_loadu_si128((const __m128i*) (text + index)));
+            if (high != 0) return index + firstSetBit(high);
+            index += 16;
+        }
+#endif
+        while (index < length && (unsigned char) text[index] < 0x80) index++;
+        return index;
+    }
+}
+
+size_t validateUtf8(const char* text, const size_t& length) {
+    const unsigned char* bytes = (const unsigned char*) text;
+    size_t index = 0;
+    while (true) {
+        index = skipAscii(text, index, length);
+        if (index >= length) return length;
+        size_t sequenceLength = validateUtf8Sequence(bytes, index, length);
+        if (sequenceLength == 0) return index;
+        index += sequenceLength;
+    }
+}
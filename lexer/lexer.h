@@ -2,49 +2,54 @@
 #ifndef LEXER_H
 #define LEXER_H
 #include <string>
+#include <string_view>
 #include <vector>
 #include "../token/token.h"
 #include "../error/error.h"
 
 struct SingleLexResult {
     Token token;
-    spError error = nullptr;
+    const ErrorRecord* error = nullptr;
 
     SingleLexResult(const Token& token) {
         this->token = token;
     }
 
-    SingleLexResult(const spError& error) {
+    SingleLexResult(const ErrorRecord* error) {
         this->error = error;
     }
 };
 
 struct MultiLexResult {
-    std::vector<Token> tokenized;
-    spError error = nullptr;
+    TokenList tokenized;
+    const ErrorRecord* error = nullptr;
 
     bool hasError() const { return error != nullptr; }
 
-    MultiLexResult(const std::vector<Token>& tokenized) {
-        this->tokenized = tokenized;
-    }
+    MultiLexResult(TokenList&& tokenized) : tokenized(std::move(tokenized)) {}
 
-    MultiLexResult(const spError& error) {
+    MultiLexResult(const ErrorRecord* error) {
         this->error = error;
     }
 };
 
 struct Lexer {
-    std::string input;
+    // Views the text kept by the SourceFile registry, which Tokens point into as well
+    std::string_view input;
     Position position;
     char current;
     int lineCount = 0;
     int inputLength;
+    // Index of the first byte that isn't valid UTF-8, checked once up front
+    int validUtf8Length;
     bool finished = false;
 
+    // Registers the input and never releases it, Tokens can outlive the Lexer
     Lexer(const std::string& input, const std::string&& filename = "<stdin>");
+    Lexer(const int& fileId);
 
     void readChar();
+    void jumpTo(const int& index);
     char peekChar(const int& num = 0) const;
     bool isNumeric(const char& c) const;
     bool isAlpha(const char& c) const;
@@ -0,0 +1,20 @@
+#pragma once
+#ifndef SCAN_H
+#define SCAN_H
+#include <cstddef>
+
+// Run scanners for the Lexer's hot loops, each returns the index of the first byte at or after index that
+// doesn't belong to the run (or length)
+// They look at 16 bytes at a time with SSE2 where it's available, and fall back to a byte at a time otherwise
+// Define BARKSCRIPT_NO_SIMD to always use the byte at a time versions
+size_t scanWhitespace(const char* text, size_t index, const size_t& length);
+size_t scanDigits(const char* text, size_t index, const size_t& length);
+size_t scanIdentifier(const char* text, size_t index, const size_t& length);
+
+// Index of the first byte that isn't part of a valid UTF-8 sequence, or length if all of it is valid
+// ASCII is skipped 32 bytes at a time with AVX2 (when the CPU has it) or 16 at a time with SSE2
+size_t validateUtf8(const char* text, const size_t& length);
+// Bytes in the UTF-8 sequence started by lead, 0 if lead can't start one
+int utf8SequenceLength(const unsigned char& lead);
+
+#endif // !SCAN_H
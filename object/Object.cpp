@@ -1,463 +1,114 @@
 #include "object.h"
-#include <math.h>
-#include <sstream>
-#include "../interpreter/interpreter.h"
-
-bool didOverflow(const double& value) {
-    return std::numeric_limits<double>::max() < value;
-}
-
-bool didUnderflow(const double& value) {
-    return -std::numeric_limits<double>::max() > value;
-}
-
-template <class T>
-RuntimeResult notSupported(RuntimeResult& rt, const T& self, spObject other, const std::string& function, const std::string& extra) {
-    return rt.failure(TypeError(self->positionStart, other->positionEnd, function + " is not supported between the types \"" + self->type + "\" and \"" + other->type + "\"!" + (extra.size() > 0 ? " (" + extra + ")" : ""), self->context));
-}
-
-template <class T>
-RuntimeResult notSupportedNoRT(const T& self, spObject other, const std::string&& function, const std::string& extra) {
-    RuntimeResult rt;
-    return notSupported(rt, self, other, function, extra);
-}
-
-template <class T>
-RuntimeResult notSupportedNoRT(const T& self, const std::string&& function, const std::string& extra) {
-    RuntimeResult rt;
-    return rt.failure(TypeError(self->positionStart, self->positionEnd, function + " is not supported for the type \"" + self->type + "\"!" + (extra.size() > 0 ? " (" + extra + ")" : ""), self->context));
-}
-
-void Object::setPosition(const Position& positionStart, const Position& positionEnd) {
-    this->positionStart = positionStart;
-    this->positionEnd = positionEnd;
-}
-
-void Object::setContext(const spContext& context) {
-    this->context = context;
-}
-
-RuntimeResult Object::unary_bang() const {
-    return RuntimeResult().success(Boolean(!this->to_bool()));
-}
-
-RuntimeResult Object::toOther(spObject other) const {
-    std::string type = other->type;
-
-    if (type == "Number") {
-        return this->toNumber();
-    } else if (type == "Boolean") {
-        return this->toBoolean();
-    } else if (type == "Null") {
-        return this->toNull();
-    } else {
-        return RuntimeResult().failure(RuntimeError(this->positionStart, this->positionEnd, "No conversion from " + this->type + " to " + other->type + " exists!", this->context));
-    }
-}
-
-RuntimeResult Object::toNull() const {
-    return RuntimeResult().success(Null());
-}
-
-Number::Number(const double& value, const bool sign) {
-    this->type = "Number";
-    this->doubleValue = value;
-    this->isPureDouble = true;
-    if (value < 0.0) this->sign = -0;
-    if (value == 0) this->isPureZero = true;
-}
-
-Number::Number(const std::string& value, const bool sign) {
-    this->type = "Number";
-    this->sign = sign;
+#include <string>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+
+Value Number(const double& value, const bool sign) {
+    Value number;
+    number.type = ValueType::Number;
+    number.doubleValue = value;
+    number.isPureDouble = true;
+    if (value < 0.0) number.sign = -0;
+    if (value == 0) number.isPureZero = true;
+    return number;
+}
+
+Value Number(const std::string_view& value, const bool sign) {
+    Value number;
+    number.type = ValueType::Number;
+    number.sign = sign;
     if (value == "Infinity") {
-        this->isInfinity = true;
+        number.isInfinity = true;
     } else if (value == "NaN") {
-        this->isNaN = true;
+        number.isNaN = true;
     } else {
-        try {
-            this->doubleValue = std::stod(value);
-            this->isPureDouble = true;
-            if (this->doubleValue == 0) this->isPureZero = true;
-        } catch (const std::out_of_range&) {
-            this->isInfinity = true;
-        }
-    }
-}
-
-std::string Number::to_string() const {
-    // https://stackoverflow.com/a/16606128/12101554
-    if (isInfinity) {
-        std::string sign;
-        if (this->sign == -0) sign += "-";
-        return sign + "Infinity";
-    } else if (isNaN) {
-        return "NaN";
-    }
-    std::ostringstream out;
-    out.precision(16);
-    out << doubleValue;
-    return out.str();
-}
-
-bool Number::to_bool() const {
-    return !(this->isPureZero || this->isNaN);
-}
-
-spObject Number::copy() const {
-    spObject other = Number();
-    other->doubleValue = this->doubleValue;
-    other->sign = this->sign;
-    other->isPureDouble = this->isPureDouble;
-    other->isPureZero = this->isPureZero;
-    other->isInfinity = this->isInfinity;
-    other->isNaN = this->isNaN;
-    other->setPosition(this->positionStart, this->positionEnd);
-    other->setContext(this->context);
-    return other;
-}
-
-RuntimeResult Number::binary_plus(spObject other) {
-    RuntimeResult rt;
-
-    if (other->type != objecttypes::Number) {
-        spObject tempOther = rt.registerRT(other->toNumber());
-        if (rt.hasError()) {
-            return notSupported(rt, this, other, "binary_plus");
-        } else {
-            other = tempOther;
-        }
-    }
-
-    if (this->isNaN || other->isNaN) return rt.success(Number("NaN"));
-    if (this->isInfinity && other->isInfinity) {
-        if (this->sign == other->sign) {
-            return rt.success(Number("Infinity", this->sign));
-        } else {
-            // Infinity + -Infinity, and -Infinity + Infinity, are both proven impossible
-            // so we need to return NaN
-            return rt.success(Number("NaN"));
-        }
-    }
-    if (this->isInfinity || other->isInfinity)
-        return rt.success(Number("Infinity", this->isInfinity ? this->sign : other->sign));
-    double result = this->doubleValue + other->doubleValue;
-    if (didOverflow(result)) return rt.success(Number("Infinity", +1));
-    if (didUnderflow(result)) return rt.success(Number("Infinity", -0));
-    return rt.success(Number(result));
-}
-
-RuntimeResult Number::binary_minus(spObject other) {
-    RuntimeResult rt;
-
-    if (other->type != objecttypes::Number) {
-        spObject tempOther = rt.registerRT(other->toNumber());
-        if (rt.hasError()) {
-            return notSupported(rt, this, other, "binary_minus");
-        } else {
-            other = tempOther;
-        }
-    }
-
-    if (this->isNaN || other->isNaN) return rt.success(Number("NaN"));
-    if (this->isInfinity && other->isInfinity) {
-        if (this->sign != other->sign) {
-            return rt.success(Number("Infinity", this->sign));
-        } else {
-            // Infinity - Infinity, and -Infinity - -Infinity, are both proven impossible
-            // so we need to return NaN
-            return rt.success(Number("NaN"));
-        }
-    }
-    if (this->isInfinity || other->isInfinity)
-        return rt.success(Number("Infinity", this->isInfinity ? this->sign : !other->sign));
-    double result = this->doubleValue - other->doubleValue;
-    if (didOverflow(result)) return rt.success(Number("Infinity", +1));
-    if (didUnderflow(result)) return rt.success(Number("Infinity", -0));
-    return rt.success(Number(result));
-}
-
-RuntimeResult Number::binary_asterisk(spObject other) {
-    RuntimeResult rt;
-
-    if (other->type != objecttypes::Number) {
-        spObject tempOther = rt.registerRT(other->toNumber());
-        if (rt.hasError()) {
-            return notSupported(rt, this, other, "binary_asterisk");
-        } else {
-            other = tempOther;
-        }
-    }
-
-    if (this->isNaN || other->isNaN) return rt.success(Number("NaN"));
-    if (this->isInfinity || other->isInfinity) {
-        if (this->isPureZero || other->isPureZero) return rt.success(Number("NaN"));
-        // a == b is the same as !(a ^ b)
-        // this->sign == other->sign
-        //       0    ==         0    -> 1
-        //       0    ==         1    -> 0
-        //       1    ==         0    -> 0
-        //       1    ==         1    -> 1
-        return rt.success(Number("Infinity", this->sign == other->sign));
-    }
-    double result = this->doubleValue * other->doubleValue;
-    if (didOverflow(result)) return rt.success(Number("Infinity", +1));
-    if (didUnderflow(result)) return rt.success(Number("Infinity", -0));
-    return rt.success(Number(result));
-}
-
-RuntimeResult Number::binary_f_slash(spObject other) {
-    RuntimeResult rt;
-
-    if (other->type != objecttypes::Number) {
-        spObject tempOther = rt.registerRT(other->toNumber());
-        if (rt.hasError()) {
-            return notSupported(rt, this, other, "binary_f_slash");
-        } else {
-            other = tempOther;
+        const char* end = value.data() + value.size();
+        std::from_chars_result result = std::from_chars(value.data(), end, number.doubleValue);
+        if (result.ec == std::errc::result_out_of_range) {
+            // Too big is Infinity, too small still rounds to the nearest subnormal (or 0) the way strtod does it
+            number.doubleValue = std::strtod(std::string(value).c_str(), nullptr);
+            if (std::isinf(number.doubleValue)) {
+                number.isInfinity = true;
+                return number;
+            }
         }
+        number.isPureDouble = true;
+        if (number.doubleValue == 0) number.isPureZero = true;
     }
-
-    if (other->isPureZero) return rt.failure(RuntimeError(other->positionStart, other->positionEnd, "Division by 0", this->context));
-    if (this->isNaN || other->isNaN) return rt.success(Number("NaN"));
-    if (this->isInfinity && other->isInfinity) return rt.success(Number("NaN"));
-    if (other->isInfinity) return rt.success(Number(0, this->sign == other->sign));
-    if (this->isInfinity) return rt.success(Number("Infinity", this->sign == other->sign));
-    double result = this->doubleValue / other->doubleValue;
-    if (didOverflow(result)) return rt.success(Number("Infinity", +1));
-    if (didUnderflow(result)) return rt.success(Number("Infinity", -0));
-    return rt.success(Number(result));
+    return number;
 }
 
-RuntimeResult Number::binary_double_asterisk(spObject other) {
-    RuntimeResult rt;
-
-    if (other->type != objecttypes::Number) {
-        spObject tempOther = rt.registerRT(other->toNumber());
-        if (rt.hasError()) {
-            return notSupported(rt, this, other, "binary_double_asterisk");
-        } else {
-            other = tempOther;
-        }
-    }
-
-    if (this->isNaN || other->isNaN) return rt.success(Number("NaN"));
-    if (other->isPureZero) return rt.success(Number(1));
-    if (other->isInfinity && other->sign == +1) return rt.success(Number("Infinity"));
-    if (other->isInfinity && other->sign == -0) return rt.success(Number(0));
-    if (this->isInfinity && other->sign == +1) return rt.success(Number("Infinity", this->sign));
-    if (this->isInfinity && other->sign == -0) return rt.success(Number(0));
-    double result = std::pow(this->doubleValue, other->doubleValue);
-    if (didOverflow(result)) return rt.success(Number("Infinity", +1));
-    if (didUnderflow(result)) return rt.success(Number("Infinity", -0));
-    return rt.success(Number(result));
+Value Boolean(const bool value) {
+    Value boolean;
+    boolean.type = ValueType::Boolean;
+    boolean.isPureDouble = true;
+    boolean.isPureZero = !value;
+    boolean.doubleValue = value;
+    return boolean;
 }
 
-RuntimeResult Number::binary_double_f_slash(spObject other) {
-    RuntimeResult rt;
-
-    if (other->type != objecttypes::Number) {
-        spObject tempOther = rt.registerRT(other->toNumber());
-        if (rt.hasError()) {
-            return notSupported(rt, this, other, "binary_double_f_slash");
-        } else {
-            other = tempOther;
-        }
-    }
-
-    if (other->isPureZero) return rt.failure(RuntimeError(other->positionStart, other->positionEnd, "Floored division by 0", this->context));
-    spObject normalDivisionResult = rt.registerRT(this->binary_f_slash(other));
-    if (rt.hasError()) return rt;
-    if (!normalDivisionResult->isPureDouble) return rt;
-    double result = std::floor(normalDivisionResult->doubleValue);
-    if (didOverflow(result)) return rt.success(Number("Infinity", +1));
-    if (didUnderflow(result)) return rt.success(Number("Infinity", -0));
-    return rt.success(Number(result));
+Value Null() {
+    return Value();
 }
 
-RuntimeResult Number::unary_plus() {
-    RuntimeResult rt;
-
-    if (isNaN) return rt.success(Number("NaN"));
-    else if (isInfinity) return rt.success(Number("Infinity", sign));
-    return rt.success(Number(this->doubleValue));
+Value NaN() {
+    static const Value nan = Number("NaN");
+    return nan;
 }
 
-RuntimeResult Number::unary_minus() {
-    RuntimeResult rt;
-
-    if (isNaN) return rt.success(Number("NaN"));
-    else if (isInfinity) return rt.success(Number("Infinity", !sign));
-    return rt.success(Number(this->doubleValue * -1));
+Value Infinity(const bool sign) {
+    static const Value positive = Number("Infinity", +1);
+    static const Value negative = Number("Infinity", -0);
+    return sign ? positive : negative;
 }
 
-RuntimeResult Number::binary_double_equal(spObject other) {
-    RuntimeResult rt;
-
-    if (other->type != objecttypes::Number) {
-        spObject tempOther = rt.registerRT(other->toNumber());
-        if (rt.hasError()) {
-            rt.error = nullptr;
-            return rt.success(Boolean(false));
-        } else {
-            other = tempOther;
-        }
-    }
-
-    return rt.success(Boolean(
-        (this->doubleValue == other->doubleValue)
-        && (this->sign == other->sign)
-        && (this->isInfinity == other->isInfinity)
-        && (this->isNaN == other->isNaN))
-    );
+Value ObjectValue(const spObject& object) {
+    Value value;
+    value.type = ValueType::Object;
+    new (&value.object) spObject(object);
+    return value;
 }
 
-RuntimeResult Number::binary_bang_equal(spObject other) {
-    RuntimeResult rt;
-
-    if (other->type != objecttypes::Number) {
-        spObject tempOther = rt.registerRT(other->toNumber());
-        if (rt.hasError()) {
-            rt.error = nullptr;
-            return rt.success(Boolean(true));
-        } else {
-            other = tempOther;
-        }
+const std::string& Value::typeName() const {
+    switch (type) {
+        case ValueType::Number: return objecttypes::Number;
+        case ValueType::Boolean: return objecttypes::Boolean;
+        case ValueType::Null: return objecttypes::Null;
+        default: return object->type;
     }
-
-    return rt.success(Boolean(
-        (this->doubleValue != other->doubleValue)
-        || (this->sign != other->sign)
-        || (this->isInfinity != other->isInfinity)
-        || (this->isNaN != other->isNaN))
-    );
 }
 
-RuntimeResult Number::binary_less_than(spObject other) {
-    RuntimeResult rt;
-
-    if (other->type != objecttypes::Number) {
-        spObject tempOther = rt.registerRT(other->toNumber());
-        if (rt.hasError()) {
-            return notSupported(rt, this, other, "binary_less_than");
-        } else {
-            other = tempOther;
+std::string Value::to_string() const {
+    switch (type) {
+        case ValueType::Number:
+        {
+            // https://stackoverflow.com/a/16606128/12101554
+            if (isInfinity) {
+                std::string sign;
+                if (this->sign == -0) sign += "-";
+                return sign + "Infinity";
+            } else if (isNaN) {
+                return "NaN";
+            }
+            // Shortest digits that read back as the same double, laid out like %g would (fixed unless very big or small)
+            char buffer[32];
+            double magnitude = std::fabs(doubleValue);
+            std::chars_format format = magnitude != 0 && (magnitude < 1e-4 || magnitude >= 1e16) ? std::chars_format::scientific : std::chars_format::fixed;
+            std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), doubleValue, format);
+            return std::string(buffer, result.ptr);
         }
+        case ValueType::Boolean: return this->isPureZero ? "false" : "true";
+        case ValueType::Null: return "null";
+        default: return object->to_string();
     }
-
-    if (this->isNaN || other->isNaN) return rt.success(Boolean(false));
-    if ((this->isInfinity && this->sign == -0) && (other->isInfinity && other->sign == +1)) return rt.success(Boolean(true));
-    if (this->isInfinity || other->isInfinity) return rt.success(Boolean(false));
-    if (this->isPureZero && other->isPureZero) return rt.success(Boolean(false));
-    return rt.success(Boolean(this->doubleValue < other->doubleValue));
 }
 
-RuntimeResult Number::binary_less_than_equal(spObject other) {
-    RuntimeResult rt;
-
-    if (other->type != objecttypes::Number) {
-        spObject tempOther = rt.registerRT(other->toNumber());
-        if (rt.hasError()) {
-            return notSupported(rt, this, other, "binary_less_than_equal");
-        } else {
-            other = tempOther;
-        }
+bool Value::to_bool() const {
+    switch (type) {
+        case ValueType::Number: return !(this->isPureZero || this->isNaN);
+        case ValueType::Boolean: return !this->isPureZero;
+        case ValueType::Null: return false;
+        default: return object->to_bool();
     }
-
-    spObject lessThan = rt.registerRT(this->binary_less_than(other));
-    if (rt.hasError()) return rt;
-    if (!lessThan->isPureZero) return rt.success(lessThan);
-    return this->binary_double_equal(other);
-}
-
-RuntimeResult Number::binary_greater_than(spObject other) {
-    RuntimeResult rt;
-
-    if (other->type != objecttypes::Number) {
-        spObject tempOther = rt.registerRT(other->toNumber());
-        if (rt.hasError()) {
-            return notSupported(rt, this, other, "binary_greater_than");
-        } else {
-            other = tempOther;
-        }
-    }
-
-    if (this->isNaN || other->isNaN) return rt.success(Boolean(false));
-    if ((this->isInfinity && this->sign == +1) && (other->isInfinity && other->sign == -0)) return rt.success(Boolean(true));
-    if (this->isInfinity || other->isInfinity) return rt.success(Boolean(false));
-    if (this->isPureZero && other->isPureZero) return rt.success(Boolean(false));
-    return rt.success(Boolean(this->doubleValue > other->doubleValue));
-}
-
-RuntimeResult Number::binary_greater_than_equal(spObject other) {
-    RuntimeResult rt;
-
-    if (other->type != objecttypes::Number) {
-        spObject tempOther = rt.registerRT(other->toNumber());
-        if (rt.hasError()) {
-            return notSupported(rt, this, other, "binary_greater_than_equal");
-        } else {
-            other = tempOther;
-        }
-    }
-
-    spObject greaterThan = rt.registerRT(this->binary_greater_than(other));
-    if (rt.hasError()) return rt;
-    if (!greaterThan->isPureDouble) return rt.success(greaterThan);
-    return this->binary_double_equal(other);
-}
-
-RuntimeResult Number::toNumber() const {
-    return RuntimeResult().success(Number(*this));
-}
-
-RuntimeResult Number::toBoolean() const {
-    return RuntimeResult().success(Boolean(this->to_bool()));
-}
-
-Boolean::Boolean(bool value) {
-    this->type = "Boolean";
-    this->isPureDouble = true;
-    this->isPureZero = !value;
-    this->doubleValue = value;
-}
-
-std::string Boolean::to_string() const {
-    return this->isPureZero ? "false" : "true";
-}
-
-bool Boolean::to_bool() const {
-    return !this->isPureZero;
-}
-
-spObject Boolean::copy() const {
-    return Boolean(this->doubleValue);
-}
-
-RuntimeResult Boolean::toNumber() const {
-    return RuntimeResult().success(Number(this->doubleValue));
-}
-
-RuntimeResult Boolean::toBoolean() const {
-    return RuntimeResult().success(Boolean(!this->isPureZero));
-}
-
-std::string Null::to_string() const {
-    return "null";
-}
-
-bool Null::to_bool() const {
-    return false;
-}
-
-spObject Null::copy() const {
-    return Null();
-}
-
-RuntimeResult Null::binary_double_equal(spObject other) {
-    return RuntimeResult().success(Boolean(other->type == "Null"));
-}
-
-RuntimeResult Null::binary_bang_equal(spObject other) {
-    return RuntimeResult().success(Boolean(other->type != "Null"));
 }
@@ -0,0 +1,470 @@
+#include "operations.h"
+#include <math.h>
+#include <limits>
+#include "../error/error.h"
+
+bool didOverflow(const double& value) {
+    return std::numeric_limits<double>::max() < value;
+}
+
+bool didUnderflow(const double& value) {
+    return -std::numeric_limits<double>::max() > value;
+}
+
+RuntimeResult notSupported(RuntimeResult& rt, const Value& self, const Value& other, const OperationSite& site, const char* function) {
+    return rt.failure(ErrorRecord(ErrorKind::Type, MessageId::BinaryNotSupported, site.selfStart, site.otherEnd, site.context.get()).with(function).with(self.typeName()).with(other.typeName()));
+}
+
+RuntimeResult notSupported(RuntimeResult& rt, const Value& self, const OperationSite& site, const char* function) {
+    return rt.failure(ErrorRecord(ErrorKind::Type, MessageId::UnaryNotSupported, site.selfStart, site.selfEnd, site.context.get()).with(function).with(self.typeName()));
+}
+
+// What toNumber does, Booleans become Numbers and anything else can't be used
+bool coerceToNumber(const Value& value, Value& result) {
+    if (value.type == ValueType::Number) {
+        result = value;
+        return true;
+    } else if (value.type == ValueType::Boolean) {
+        result = Number(value.doubleValue);
+        return true;
+    }
+    return false;
+}
+
+// Every kernel below only gets operands the dispatch matrix already checked the types of
+// A Boolean has the same fields as the Number it coerces to, so the Number kernels take Booleans on either side as is
+RuntimeResult numbers_plus(const Value& self, const Value& other, const OperationSite& site) {
+    RuntimeResult rt;
+
+    if (self.isNaN || other.isNaN) return rt.success(NaN());
+    if (self.isInfinity && other.isInfinity) {
+        if (self.sign == other.sign) {
+            return rt.success(Infinity(self.sign));
+        } else {
+            // Infinity + -Infinity, and -Infinity + Infinity, are both proven impossible
+            // so we need to return NaN
+            return rt.success(NaN());
+        }
+    }
+    if (self.isInfinity || other.isInfinity)
+        return rt.success(Infinity(self.isInfinity ? self.sign : other.sign));
+    double result = self.doubleValue + other.doubleValue;
+    if (didOverflow(result)) return rt.success(Infinity(+1));
+    if (didUnderflow(result)) return rt.success(Infinity(-0));
+    return rt.success(Number(result));
+}
+
+RuntimeResult numbers_minus(const Value& self, const Value& other, const OperationSite& site) {
+    RuntimeResult rt;
+
+    if (self.isNaN || other.isNaN) return rt.success(NaN());
+    if (self.isInfinity && other.isInfinity) {
+        if (self.sign != other.sign) {
+            return rt.success(Infinity(self.sign));
+        } else {
+            // Infinity - Infinity, and -Infinity - -Infinity, are both proven impossible
+            // so we need to return NaN
+            return rt.success(NaN());
+        }
+    }
+    if (self.isInfinity || other.isInfinity)
+        return rt.success(Infinity(self.isInfinity ? self.sign : !other.sign));
+    double result = self.doubleValue - other.doubleValue;
+    if (didOverflow(result)) return rt.success(Infinity(+1));
+    if (didUnderflow(result)) return rt.success(Infinity(-0));
+    return rt.success(Number(result));
+}
+
+RuntimeResult numbers_asterisk(const Value& self, const Value& other, const OperationSite& site) {
+    RuntimeResult rt;
+
+    if (self.isNaN || other.isNaN) return rt.success(NaN());
+    if (self.isInfinity || other.isInfinity) {
+        if (self.isPureZero || other.isPureZero) return rt.success(NaN());
+        // a == b is the same as !(a ^ b)
+        // self.sign == other.sign
+        //      0    ==        0    -> 1
+        //      0    ==        1    -> 0
+        //      1    ==        0    -> 0
+        //      1    ==        1    -> 1
+        return rt.success(Infinity(self.sign == other.sign));
+    }
+    double result = self.doubleValue * other.doubleValue;
+    if (didOverflow(result)) return rt.success(Infinity(+1));
+    if (didUnderflow(result)) return rt.success(Infinity(-0));
+    return rt.success(Number(result));
+}
+
+RuntimeResult numbers_f_slash(const Value& self, const Value& other, const OperationSite& site) {
+    RuntimeResult rt;
+
+    if (other.isPureZero) return rt.failure(ErrorRecord(ErrorKind::Runtime, MessageId::DivisionByZero, site.otherStart, site.otherEnd, site.context.get()));
+    if (self.isNaN || other.isNaN) return rt.success(NaN());
+    if (self.isInfinity && other.isInfinity) return rt.success(NaN());
+    if (other.isInfinity) return rt.success(Number(0, self.sign == other.sign));
+    if (self.isInfinity) return rt.success(Infinity(self.sign == other.sign));
+    double result = self.doubleValue / other.doubleValue;
+    if (didOverflow(result)) return rt.success(Infinity(+1));
+    if (didUnderflow(result)) return rt.success(Infinity(-0));
+    return rt.success(Number(result));
+}
+
+RuntimeResult numbers_double_asterisk(const Value& self, const Value& other, const OperationSite& site) {
+    RuntimeResult rt;
+
+    if (self.isNaN || other.isNaN) return rt.success(NaN());
+    if (other.isPureZero) return rt.success(Number(1));
+    if (other.isInfinity && other.sign == +1) return rt.success(Infinity());
+    if (other.isInfinity && other.sign == -0) return rt.success(Number(0));
+    if (self.isInfinity && other.sign == +1) return rt.success(Infinity(self.sign));
+    if (self.isInfinity && other.sign == -0) return rt.success(Number(0));
+    double result = std::pow(self.doubleValue, other.doubleValue);
+    if (didOverflow(result)) return rt.success(Infinity(+1));
+    if (didUnderflow(result)) return rt.success(Infinity(-0));
+    return rt.success(Number(result));
+}
+
+RuntimeResult numbers_double_f_slash(const Value& self, const Value& other, const OperationSite& site) {
+    RuntimeResult rt;
+
+    if (other.isPureZero) return rt.failure(ErrorRecord(ErrorKind::Runtime, MessageId::FlooredDivisionByZero, site.otherStart, site.otherEnd, site.context.get()));
+    Value normalDivisionResult = rt.registerRT(numbers_f_slash(self, other, site));
+    if (rt.hasError()) return rt;
+    // Infinity and NaN have nothing to floor
+    if (!normalDivisionResult.isPureDouble) return rt.success(normalDivisionResult);
+    double result = std::floor(normalDivisionResult.doubleValue);
+    if (didOverflow(result)) return rt.success(Infinity(+1));
+    if (didUnderflow(result)) return rt.success(Infinity(-0));
+    return rt.success(Number(result));
+}
+
+RuntimeResult number_unary_plus(const Value& self, const OperationSite& site) {
+    RuntimeResult rt;
+
+    if (self.isNaN) return rt.success(NaN());
+    else if (self.isInfinity) return rt.success(Infinity(self.sign));
+    return rt.success(Number(self.doubleValue));
+}
+
+RuntimeResult number_unary_minus(const Value& self, const OperationSite& site) {
+    RuntimeResult rt;
+
+    if (self.isNaN) return rt.success(NaN());
+    else if (self.isInfinity) return rt.success(Infinity(!self.sign));
+    return rt.success(Number(self.doubleValue * -1));
+}
+
+RuntimeResult any_unary_bang(const Value& self, const OperationSite& site) {
+    return RuntimeResult().success(Boolean(!self.to_bool()));
+}
+
+RuntimeResult numbers_double_equal(const Value& self, const Value& other, const OperationSite& site) {
+    return RuntimeResult().success(Boolean(
+        (self.doubleValue == other.doubleValue)
+        && (self.sign == other.sign)
+        && (self.isInfinity == other.isInfinity)
+        && (self.isNaN == other.isNaN))
+    );
+}
+
+RuntimeResult numbers_bang_equal(const Value& self, const Value& other, const OperationSite& site) {
+    return RuntimeResult().success(Boolean(
+        (self.doubleValue != other.doubleValue)
+        || (self.sign != other.sign)
+        || (self.isInfinity != other.isInfinity)
+        || (self.isNaN != other.isNaN))
+    );
+}
+
+RuntimeResult null_double_equal(const Value& self, const Value& other, const OperationSite& site) {
+    return RuntimeResult().success(Boolean(other.type == ValueType::Null));
+}
+
+RuntimeResult null_bang_equal(const Value& self, const Value& other, const OperationSite& site) {
+    return RuntimeResult().success(Boolean(other.type != ValueType::Null));
+}
+
+// A Number or Boolean is never equal to anything it can't be coerced to
+RuntimeResult never_equal(const Value& self, const Value& other, const OperationSite& site) {
+    return RuntimeResult().success(Boolean(false));
+}
+
+RuntimeResult always_not_equal(const Value& self, const Value& other, const OperationSite& site) {
+    return RuntimeResult().success(Boolean(true));
+}
+
+RuntimeResult numbers_less_than(const Value& self, const Value& other, const OperationSite& site) {
+    RuntimeResult rt;
+
+    if (self.isNaN || other.isNaN) return rt.success(Boolean(false));
+    if ((self.isInfinity && self.sign == -0) && (other.isInfinity && other.sign == +1)) return rt.success(Boolean(true));
+    if (self.isInfinity || other.isInfinity) return rt.success(Boolean(false));
+    if (self.isPureZero && other.isPureZero) return rt.success(Boolean(false));
+    return rt.success(Boolean(self.doubleValue < other.doubleValue));
+}
+
+RuntimeResult numbers_less_than_equal(const Value& self, const Value& other, const OperationSite& site) {
+    RuntimeResult rt;
+
+    Value lessThan = rt.registerRT(numbers_less_than(self, other, site));
+    if (rt.hasError()) return rt;
+    if (!lessThan.isPureZero) return rt.success(lessThan);
+    return numbers_double_equal(self, other, site);
+}
+
+RuntimeResult numbers_greater_than(const Value& self, const Value& other, const OperationSite& site) {
+    RuntimeResult rt;
+
+    if (self.isNaN || other.isNaN) return rt.success(Boolean(false));
+    if ((self.isInfinity && self.sign == +1) && (other.isInfinity && other.sign == -0)) return rt.success(Boolean(true));
+    if (self.isInfinity || other.isInfinity) return rt.success(Boolean(false));
+    if (self.isPureZero && other.isPureZero) return rt.success(Boolean(false));
+    return rt.success(Boolean(self.doubleValue > other.doubleValue));
+}
+
+RuntimeResult numbers_greater_than_equal(const Value& self, const Value& other, const OperationSite& site) {
+    RuntimeResult rt;
+
+    Value greaterThan = rt.registerRT(numbers_greater_than(self, other, site));
+    if (rt.hasError()) return rt;
+    if (!greaterThan.isPureZero) return rt.success(greaterThan);
+    return numbers_double_equal(self, other, site);
+}
+
+const char* const binaryOperatorNames[] = {
+    "binary_plus",
+    "binary_minus",
+    "binary_asterisk",
+    "binary_f_slash",
+    "binary_double_asterisk",
+    "binary_double_f_slash",
+    "binary_double_equal",
+    "binary_bang_equal",
+    "binary_less_than",
+    "binary_less_than_equal",
+    "binary_greater_than",
+    "binary_greater_than_equal",
+};
+
+const char* const unaryOperatorNames[] = {
+    "unary_plus",
+    "unary_minus",
+    "unary_bang",
+};
+
+template<BinaryOperator Operator>
+RuntimeResult binaryNotSupported(const Value& self, const Value& other, const OperationSite& site) {
+    RuntimeResult rt;
+    return notSupported(rt, self, other, site, binaryOperatorNames[(int) Operator]);
+}
+
+template<UnaryOperator Operator>
+RuntimeResult unaryNotSupported(const Value& self, const OperationSite& site) {
+    RuntimeResult rt;
+    return notSupported(rt, self, site, unaryOperatorNames[(int) Operator]);
+}
+
+const int valueTypeCount = (int) ValueType::COUNT;
+const int binaryOperatorCount = (int) BinaryOperator::COUNT;
+const int unaryOperatorCount = (int) UnaryOperator::COUNT;
+
+// The kernel for every (operator, self's type, other's type), so finding it is one indexed load
+// A pair an operator has no kernel for reports that the operator isn't supported between those types, so a new
+// ValueType only needs the kernels for the pairs it does support
+struct BinaryDispatchMatrix {
+    BinaryOperation kernels[binaryOperatorCount][valueTypeCount][valueTypeCount] = {};
+
+    template<BinaryOperator Operator>
+    constexpr void set(const BinaryOperation& numbers, const BinaryOperation& mismatched) {
+        for (int self = 0; self < valueTypeCount; self++) {
+            for (int other = 0; other < valueTypeCount; other++) {
+                kernels[(int) Operator][self][other] = &binaryNotSupported<Operator>;
+            }
+        }
+        const ValueType numeric[] = { ValueType::Number, ValueType::Boolean };
+        for (const ValueType& self : numeric) {
+            for (int other = 0; other < valueTypeCount; other++) {
+                bool isNumeric = other == (int) ValueType::Number || other == (int) ValueType::Boolean;
+                if (isNumeric) kernels[(int) Operator][(int) self][other] = numbers;
+                else if (mismatched != nullptr) kernels[(int) Operator][(int) self][other] = mismatched;
+            }
+        }
+    }
+
+    constexpr BinaryDispatchMatrix() {
+        set<BinaryOperator::Plus>(&numbers_plus, nullptr);
+        set<BinaryOperator::Minus>(&numbers_minus, nullptr);
+        set<BinaryOperator::Asterisk>(&numbers_asterisk, nullptr);
+        set<BinaryOperator::FSlash>(&numbers_f_slash, nullptr);
+        set<BinaryOperator::DoubleAsterisk>(&numbers_double_asterisk, nullptr);
+        set<BinaryOperator::DoubleFSlash>(&numbers_double_f_slash, nullptr);
+        set<BinaryOperator::DoubleEqual>(&numbers_double_equal, &never_equal);
+        set<BinaryOperator::BangEqual>(&numbers_bang_equal, &always_not_equal);
+        set<BinaryOperator::LessThan>(&numbers_less_than, nullptr);
+        set<BinaryOperator::LessThanEqual>(&numbers_less_than_equal, nullptr);
+        set<BinaryOperator::GreaterThan>(&numbers_greater_than, nullptr);
+        set<BinaryOperator::GreaterThanEqual>(&numbers_greater_than_equal, nullptr);
+        // null can be compared with anything
+        for (int other = 0; other < valueTypeCount; other++) {
+            kernels[(int) BinaryOperator::DoubleEqual][(int) ValueType::Null][other] = &null_double_equal;
+            kernels[(int) BinaryOperator::BangEqual][(int) ValueType::Null][other] = &null_bang_equal;
+        }
+    }
+};
+
+struct UnaryDispatchMatrix {
+    UnaryOperation kernels[unaryOperatorCount][valueTypeCount] = {};
+
+    constexpr UnaryDispatchMatrix() {
+        for (int self = 0; self < valueTypeCount; self++) {
+            bool isNumeric = self == (int) ValueType::Number || self == (int) ValueType::Boolean;
+            kernels[(int) UnaryOperator::Plus][self] = isNumeric ? &number_unary_plus : &unaryNotSupported<UnaryOperator::Plus>;
+            kernels[(int) UnaryOperator::Minus][self] = isNumeric ? &number_unary_minus : &unaryNotSupported<UnaryOperator::Minus>;
+            // Everything has a truth value
+            kernels[(int) UnaryOperator::Bang][self] = &any_unary_bang;
+        }
+    }
+};
+
+constexpr BinaryDispatchMatrix binaryDispatch;
+constexpr UnaryDispatchMatrix unaryDispatch;
+
+BinaryOperator binaryOperatorFor(const TokenKind& kind) {
+    switch (kind) {
+        case TokenKind::PLUS: return BinaryOperator::Plus;
+        case TokenKind::MINUS: return BinaryOperator::Minus;
+        case TokenKind::ASTERISK: return BinaryOperator::Asterisk;
+        case TokenKind::F_SLASH: return BinaryOperator::FSlash;
+        case TokenKind::DOUBLE_ASTERISK: return BinaryOperator::DoubleAsterisk;
+        case TokenKind::DOUBLE_F_SLASH: return BinaryOperator::DoubleFSlash;
+        case TokenKind::DOUBLE_EQUAL: return BinaryOperator::DoubleEqual;
+        case TokenKind::BANG_EQUAL: return BinaryOperator::BangEqual;
+        case TokenKind::LESS_THAN: return BinaryOperator::LessThan;
+        case TokenKind::LESS_THAN_EQUAL: return BinaryOperator::LessThanEqual;
+        case TokenKind::GREATER_THAN: return BinaryOperator::GreaterThan;
+        case TokenKind::GREATER_THAN_EQUAL: return BinaryOperator::GreaterThanEqual;
+        default: return BinaryOperator::COUNT;
+    }
+}
+
+UnaryOperator unaryOperatorFor(const TokenKind& kind) {
+    switch (kind) {
+        case TokenKind::PLUS: return UnaryOperator::Plus;
+        case TokenKind::MINUS: return UnaryOperator::Minus;
+        case TokenKind::BANG: return UnaryOperator::Bang;
+        default: return UnaryOperator::COUNT;
+    }
+}
+
+RuntimeResult binaryOperation(const BinaryOperator& op, const Value& self, const Value& other, const OperationSite& site) {
+    return binaryDispatch.kernels[(int) op][(int) self.type][(int) other.type](self, other, site);
+}
+
+RuntimeResult unaryOperation(const UnaryOperator& op, const Value& self, const OperationSite& site) {
+    return unaryDispatch.kernels[(int) op][(int) self.type](self, site);
+}
+
+// A finite double, or the Infinity it overflowed into
+Value finiteOrInfinity(const double& result) {
+    if (didOverflow(result)) return Infinity(+1);
+    if (didUnderflow(result)) return Infinity(-0);
+    return Number(result);
+}
+
+bool quick_binary_plus(const Value& self, const Value& other, Value& result) {
+    result = finiteOrInfinity(self.doubleValue + other.doubleValue);
+    return true;
+}
+
+bool quick_binary_minus(const Value& self, const Value& other, Value& result) {
+    result = finiteOrInfinity(self.doubleValue - other.doubleValue);
+    return true;
+}
+
+bool quick_binary_asterisk(const Value& self, const Value& other, Value& result) {
+    result = finiteOrInfinity(self.doubleValue * other.doubleValue);
+    return true;
+}
+
+bool quick_binary_f_slash(const Value& self, const Value& other, Value& result) {
+    if (other.isPureZero) return false;
+    result = finiteOrInfinity(self.doubleValue / other.doubleValue);
+    return true;
+}
+
+bool quick_binary_double_asterisk(const Value& self, const Value& other, Value& result) {
+    result = other.isPureZero ? Number(1) : finiteOrInfinity(std::pow(self.doubleValue, other.doubleValue));
+    return true;
+}
+
+bool quick_binary_double_f_slash(const Value& self, const Value& other, Value& result) {
+    if (other.isPureZero) return false;
+    Value normalDivisionResult = finiteOrInfinity(self.doubleValue / other.doubleValue);
+    result = normalDivisionResult.isPureDouble ? finiteOrInfinity(std::floor(normalDivisionResult.doubleValue)) : normalDivisionResult;
+    return true;
+}
+
+bool quick_unary_plus(const Value& self, Value& result) {
+    result = Number(self.doubleValue);
+    return true;
+}
+
+bool quick_unary_minus(const Value& self, Value& result) {
+    result = Number(self.doubleValue * -1);
+    return true;
+}
+
+bool quick_unary_bang(const Value& self, Value& result) {
+    result = Boolean(self.isPureZero);
+    return true;
+}
+
+// A Boolean's sign is always +1, the same as the Number it coerces to
+bool quick_binary_double_equal(const Value& self, const Value& other, Value& result) {
+    result = Boolean(self.doubleValue == other.doubleValue && self.sign == other.sign);
+    return true;
+}
+
+bool quick_binary_bang_equal(const Value& self, const Value& other, Value& result) {
+    result = Boolean(self.doubleValue != other.doubleValue || self.sign != other.sign);
+    return true;
+}
+
+bool quick_binary_less_than(const Value& self, const Value& other, Value& result) {
+    result = Boolean(!(self.isPureZero && other.isPureZero) && self.doubleValue < other.doubleValue);
+    return true;
+}
+
+bool quick_binary_less_than_equal(const Value& self, const Value& other, Value& result) {
+    quick_binary_less_than(self, other, result);
+    if (result.isPureZero) quick_binary_double_equal(self, other, result);
+    return true;
+}
+
+bool quick_binary_greater_than(const Value& self, const Value& other, Value& result) {
+    result = Boolean(!(self.isPureZero && other.isPureZero) && self.doubleValue > other.doubleValue);
+    return true;
+}
+
+bool quick_binary_greater_than_equal(const Value& self, const Value& other, Value& result) {
+    quick_binary_greater_than(self, other, result);
+    if (result.isPureZero) quick_binary_double_equal(self, other, result);
+    return true;
+}
+
+RuntimeResult toNumber(const Value& self, const OperationSite& site) {
+    RuntimeResult rt;
+    Value number;
+    if (!coerceToNumber(self, number)) return notSupported(rt, self, site, "toNumber");
+    return rt.success(number);
+}
+
+RuntimeResult toBoolean(const Value& self, const OperationSite& site) {
+    RuntimeResult rt;
+    if (!self.isNumeric()) return notSupported(rt, self, site, "toBoolean");
+    return rt.success(Boolean(self.to_bool()));
+}
+
+RuntimeResult toNull(const Value& self, const OperationSite& site) {
+    return RuntimeResult().success(Null());
+}
@@ -2,156 +2,131 @@
 #ifndef OBJECT_H
 #define OBJECT_H
 #include <string>
+#include <string_view>
 #include <memory>
-#include "../token/token.h"
-#include "../position/position.h"
-#include "../context/context.h"
-#include "../interpreter/interpreter.h"
+#include <new>
+#include <utility>
+#include <cstdint>
+#include "../pool/pool.h"
 
 namespace objecttypes {
     using namespace std;
 
     const string Number = "Number";
+    const string Boolean = "Boolean";
+    const string Null = "Null";
 }
 
 struct Object;
 
-typedef std::shared_ptr<Object> spObject;
+// Objects are never changed once made, so every Value holding one (a variable, a copy of it on the stack, a result)
+// shares the same Object and reading it is a refcount increment
+typedef std::shared_ptr<const Object> spObject;
 
 // Polymorphism without having to cast to unknown types later on
 // https://stackoverflow.com/a/42539569/12101554
 // https://ideone.com/4jdhfZ
+// Objects and their control blocks come from the thread's block pool
 template<class ObjectType>
 spObject makeSharedObject(ObjectType&& object) {
-    return std::make_shared<std::remove_reference_t<ObjectType>>(std::forward<ObjectType>(object));
+    typedef std::remove_cv_t<std::remove_reference_t<ObjectType>> Type;
+    return std::allocate_shared<Type>(PoolAllocator<Type>(), std::forward<ObjectType>(object));
 }
 
-struct RuntimeResult;
-
-template <class T>
-extern RuntimeResult notSupported(RuntimeResult& rt, const T& self, spObject other, const std::string& function, const std::string& extra = "");
-
-template <class T>
-extern RuntimeResult notSupportedNoRT(const T& self, spObject other, const std::string&& function, const std::string& extra = "");
-
-template <class T>
-extern RuntimeResult notSupportedNoRT(const T& self, const std::string&& function, const std::string& extra = "");
-
+// Only reference types live on the heap, Numbers, Booleans and Null are held directly in a Value
+// Objects never come from the statement Arena since they can outlive it in a SymbolTable
+// They don't know their context or position either, whoever evaluates a reference to one already has both
 struct Object {
-    std::string stringValue;
-    double doubleValue = 0.0;
-    bool sign = +1;
-    bool isInfinity = false;
-    bool isNaN = false;
-    bool isPureDouble = false;
-    bool isPureZero = false;
-
     std::string type = "UNKNOWN_OBJECT";
-    Position positionStart;
-    Position positionEnd;
-    spContext context;
 
-    void setPosition(const Position& positionStart, const Position& positionEnd);
-    void setContext(const spContext& context);
+    virtual ~Object() {}
 
     std::string virtual to_string() const { return "to_string is not implemented for type " + this->type; };
     bool virtual to_bool() const = 0;
-    spObject virtual copy() const = 0;
-
-    RuntimeResult virtual binary_plus(spObject other) { return notSupportedNoRT(this, other, "binary_plus"); };
-    RuntimeResult virtual binary_minus(spObject other) { return notSupportedNoRT(this, other, "binary_minus"); };
-    RuntimeResult virtual binary_asterisk(spObject other) { return notSupportedNoRT(this, other, "binary_asterisk"); };
-    RuntimeResult virtual binary_f_slash(spObject other) { return notSupportedNoRT(this, other, "binary_f_slash"); };
-    RuntimeResult virtual binary_double_asterisk(spObject other) { return notSupportedNoRT(this, other, "binary_double_asterisk"); };
-    RuntimeResult virtual binary_double_f_slash(spObject other) { return notSupportedNoRT(this, other, "binary_double_f_slash"); };
-
-    RuntimeResult virtual unary_plus() { return notSupportedNoRT(this, "unary_plus"); };
-    RuntimeResult virtual unary_minus() { return notSupportedNoRT(this, "unary_minus"); };
-
-    RuntimeResult unary_bang() const;
 
-    RuntimeResult virtual binary_double_equal(spObject other) { return notSupportedNoRT(this, other, "binary_double_equal"); };
-    RuntimeResult virtual binary_bang_equal(spObject other) { return notSupportedNoRT(this, other, "binary_bang_equal"); };
-    RuntimeResult virtual binary_less_than(spObject other) { return notSupportedNoRT(this, other, "binary_less_than"); };
-    RuntimeResult virtual binary_less_than_equal(spObject other) { return notSupportedNoRT(this, other, "binary_less_than_equal"); };
-    RuntimeResult virtual binary_greater_than(spObject other) { return notSupportedNoRT(this, other, "binary_greater_than"); };
-    RuntimeResult virtual binary_greater_than_equal(spObject other) { return notSupportedNoRT(this, other, "binary_greater_than_equal"); };
-
-    RuntimeResult toOther(spObject other) const;
-    RuntimeResult virtual toNumber() const { return notSupportedNoRT(this, "toNumber"); }
-    RuntimeResult virtual toBoolean() const { return notSupportedNoRT(this, "toBoolean"); }
-    RuntimeResult toNull() const;
-
-    virtual operator spObject() = 0;
+    virtual operator spObject() const = 0;
     // All children should have the code below
-    //operator spObject() override {
+    //operator spObject() const override {
     //    return makeSharedObject(*this);
     //}
 };
 
-struct Number : Object {
-    Number() { this->type = "Number"; };
-    Number(const double& value, const bool sign = +1);
-    Number(const std::string& value, const bool sign = +1);
-
-    std::string to_string() const override;
-    bool to_bool() const override;
-    spObject copy() const override;
-
-    RuntimeResult binary_plus(spObject other) override;
-    RuntimeResult binary_minus(spObject other) override;
-    RuntimeResult binary_asterisk(spObject other) override;
-    RuntimeResult binary_f_slash(spObject other) override;
-    RuntimeResult binary_double_asterisk(spObject other) override;
-    RuntimeResult binary_double_f_slash(spObject other) override;
-
-    RuntimeResult unary_plus() override;
-    RuntimeResult unary_minus() override;
-
-    RuntimeResult binary_double_equal(spObject other) override;
-    RuntimeResult binary_bang_equal(spObject other) override;
-    RuntimeResult binary_less_than(spObject other) override;
-    RuntimeResult binary_less_than_equal(spObject other) override;
-    RuntimeResult binary_greater_than(spObject other) override;
-    RuntimeResult binary_greater_than_equal(spObject other) override;
-
-    RuntimeResult toNumber() const override;
-    RuntimeResult toBoolean() const override;
-
-    operator spObject() override {
-        return makeSharedObject(*this);
-    }
+enum class ValueType : uint8_t {
+    Number,
+    Boolean,
+    Null,
+    Object,
+    COUNT,
 };
 
-struct Boolean : Number {
-    Boolean() { this->type = "Boolean"; this->isPureZero = 0; this->isPureDouble = true; }
-    Boolean(const bool value);
-
-    std::string to_string() const override;
-    bool to_bool() const override;
-    spObject copy() const override;
-
-    RuntimeResult toNumber() const override;
-    RuntimeResult toBoolean() const override;
-
-    operator spObject() override {
-        return makeSharedObject(*this);
+// Everything the language works with, passed around by value so arithmetic never has to allocate
+// The number and the Object share their storage, so copying anything but an Object is copying bytes and only an
+// Object's reference count is ever touched
+// type only becomes Object through ObjectValue(), which is what constructs object
+struct Value {
+    ValueType type = ValueType::Null;
+    bool sign = +1;
+    bool isInfinity = false;
+    bool isNaN = false;
+    bool isPureDouble = false;
+    bool isPureZero = false;
+    union {
+        // Numbers and Booleans, 0 for Null
+        double doubleValue = 0.0;
+        // Only for ValueType::Object
+        spObject object;
+    };
+
+    Value() {}
+    Value(const Value& other) : type(other.type), sign(other.sign), isInfinity(other.isInfinity), isNaN(other.isNaN), isPureDouble(other.isPureDouble), isPureZero(other.isPureZero) {
+        if (type == ValueType::Object) new (&object) spObject(other.object);
+        else doubleValue = other.doubleValue;
+    }
+    Value(Value&& other) noexcept : type(other.type), sign(other.sign), isInfinity(other.isInfinity), isNaN(other.isNaN), isPureDouble(other.isPureDouble), isPureZero(other.isPureZero) {
+        if (type == ValueType::Object) new (&object) spObject(std::move(other.object));
+        else doubleValue = other.doubleValue;
+    }
+    Value& operator=(const Value& other) {
+        // Copied first, other may only be alive through the Object this one is about to let go of
+        Value copy(other);
+        return *this = std::move(copy);
+    }
+    Value& operator=(Value&& other) noexcept {
+        if (this == &other) return *this;
+        if (type == ValueType::Object && other.type == ValueType::Object) {
+            object = std::move(other.object);
+        } else {
+            if (type == ValueType::Object) object.~spObject();
+            if (other.type == ValueType::Object) new (&object) spObject(std::move(other.object));
+            else doubleValue = other.doubleValue;
+        }
+        type = other.type;
+        sign = other.sign;
+        isInfinity = other.isInfinity;
+        isNaN = other.isNaN;
+        isPureDouble = other.isPureDouble;
+        isPureZero = other.isPureZero;
+        return *this;
+    }
+    ~Value() {
+        if (type == ValueType::Object) object.~spObject();
     }
-};
-
-struct Null : Object {
-    Null() { this->type = "Null"; }
-
-    std::string to_string() const override;
-    bool to_bool() const override;
-    spObject copy() const override;
 
-    RuntimeResult binary_double_equal(spObject other) override;
-    RuntimeResult binary_bang_equal(spObject other) override;
+    // Booleans share the Number representation, so every Number operator accepts them too
+    bool isNumeric() const { return type == ValueType::Number || type == ValueType::Boolean; }
 
-    operator spObject() override {
-        return makeSharedObject(*this);
-    }
+    const std::string& typeName() const;
+    std::string to_string() const;
+    bool to_bool() const;
 };
 
+Value Number(const double& value, const bool sign = +1);
+Value Number(const std::string_view& value, const bool sign = +1);
+Value Boolean(const bool value);
+Value Null();
+// Made once, so the operators that keep returning them don't parse them from their names each time
+Value NaN();
+Value Infinity(const bool sign = +1);
+Value ObjectValue(const spObject& object);
+
 #endif // !OBJECT_H
@@ -0,0 +1,87 @@
+#pragma once
+#ifndef OPERATIONS_H
+#define OPERATIONS_H
+#include <string>
+#include <cstdint>
+#include "object.h"
+#include "../token/tokens.h"
+#include "../position/position.h"
+#include "../context/context.h"
+#include "../interpreter/interpreter.h"
+
+// Values don't know where they came from, so whoever evaluates an operator says where its operands are
+// For unary operators self and other are the same operand
+struct OperationSite {
+    const Position& selfStart;
+    const Position& selfEnd;
+    const Position& otherStart;
+    const Position& otherEnd;
+    const spContext& context;
+};
+
+typedef RuntimeResult(*BinaryOperation)(const Value& self, const Value& other, const OperationSite& site);
+typedef RuntimeResult(*UnaryOperation)(const Value& self, const OperationSite& site);
+
+// Every operator, in the same order as their OpCodes
+enum class BinaryOperator : uint8_t {
+    Plus,
+    Minus,
+    Asterisk,
+    FSlash,
+    DoubleAsterisk,
+    DoubleFSlash,
+    DoubleEqual,
+    BangEqual,
+    LessThan,
+    LessThanEqual,
+    GreaterThan,
+    GreaterThanEqual,
+    COUNT,
+};
+
+enum class UnaryOperator : uint8_t {
+    Plus,
+    Minus,
+    Bang,
+    COUNT,
+};
+
+// COUNT for a token that isn't an operator
+BinaryOperator binaryOperatorFor(const TokenKind& kind);
+UnaryOperator unaryOperatorFor(const TokenKind& kind);
+
+// Finds the kernel for the operator and both operands' types in a dispatch matrix and runs it, the kernel for a pair
+// of types that doesn't support the operator reports that with both type names
+RuntimeResult binaryOperation(const BinaryOperator& op, const Value& self, const Value& other, const OperationSite& site);
+RuntimeResult unaryOperation(const UnaryOperator& op, const Value& self, const OperationSite& site);
+
+// The same operators for the Interpreter's specialized nodes, whose guard has already checked that every operand is
+// a Number or Boolean that is neither Infinity nor NaN, so none of the generic operators' special cases apply and
+// nothing can fail
+// They return false when the generic operator has to run after all, which is only for division by 0 and its error
+typedef bool(*QuickBinaryOperation)(const Value& self, const Value& other, Value& result);
+typedef bool(*QuickUnaryOperation)(const Value& self, Value& result);
+
+bool quick_binary_plus(const Value& self, const Value& other, Value& result);
+bool quick_binary_minus(const Value& self, const Value& other, Value& result);
+bool quick_binary_asterisk(const Value& self, const Value& other, Value& result);
+bool quick_binary_f_slash(const Value& self, const Value& other, Value& result);
+bool quick_binary_double_asterisk(const Value& self, const Value& other, Value& result);
+bool quick_binary_double_f_slash(const Value& self, const Value& other, Value& result);
+
+bool quick_unary_plus(const Value& self, Value& result);
+bool quick_unary_minus(const Value& self, Value& result);
+bool quick_unary_bang(const Value& self, Value& result);
+
+bool quick_binary_double_equal(const Value& self, const Value& other, Value& result);
+bool quick_binary_bang_equal(const Value& self, const Value& other, Value& result);
+bool quick_binary_less_than(const Value& self, const Value& other, Value& result);
+bool quick_binary_less_than_equal(const Value& self, const Value& other, Value& result);
+bool quick_binary_greater_than(const Value& self, const Value& other, Value& result);
+bool quick_binary_greater_than_equal(const Value& self, const Value& other, Value& result);
+
+RuntimeResult toNumber(const Value& self, const OperationSite& site);
+RuntimeResult toBoolean(const Value& self, const OperationSite& site);
+RuntimeResult toNull(const Value& self, const OperationSite& site);
+
+#endif // !OPERATIONS_H
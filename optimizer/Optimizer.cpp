@@ -0,0 +1,84 @@
+#include "optimizer.h"
+#include <string>
+#include <vector>
+#include "../token/tokens.h"
+#include "../object/object.h"
+#include "../object/operations.h"
+#include "../symboltable/symboltable.h"
+
+// Nothing folded here is reported, so the errors operations build never need a context
+const spContext noContext = nullptr;
+
+spNode Optimizer::optimize(const spNode& node) {
+    // Children before their parents without recursing, so any tree the Parser can make can be optimized
+    // Folding a node replaces it in its parent's slot, which is only looked at again once every child is done
+    spNode optimized = node;
+    pending.clear();
+    pending.push_back({ &optimized, false });
+    while (!pending.empty()) {
+        Pending next = pending.back();
+        pending.pop_back();
+        spNode& current = *next.node;
+        if (next.childrenOptimized) {
+            current = optimizeNode(current);
+            continue;
+        }
+        pending.push_back({ &current, true });
+        // Pushed backwards so they are optimized in the order they run
+        for (auto statement = current->statementNodes.rbegin(); statement != current->statementNodes.rend(); statement++) {
+            pending.push_back({ &*statement, false });
+        }
+        for (spNode* child : { &current->rightNode, &current->leftNode, &current->valueNode }) {
+            if (*child != nullptr) pending.push_back({ child, false });
+        }
+    }
+    return optimized;
+}
+
+spNode Optimizer::optimizeNode(const spNode& node) {
+    switch (node->kind) {
+        case NodeKind::Number: return optimizeNumberNode(node);
+        case NodeKind::VariableRetrievement: return optimizeVariableRetrievementNode(node);
+        case NodeKind::BinaryOperator: return optimizeBinaryOperatorNode(node);
+        case NodeKind::UnaryOperator: return optimizeUnaryOperatorNode(node);
+        // Programs, declarations and assignments have nothing to fold besides their children
+        // and the engines report anything they don't know about
+        default: return node;
+    }
+}
+
+spNode Optimizer::optimizeNumberNode(const spNode& node) {
+    return ConstantNode(node, Number(node->token.value));
+}
+
+spNode Optimizer::optimizeVariableRetrievementNode(const spNode& node) {
+    // Global constants are looked up before any scope and can never be set, so they are safe to inline
+    auto global = globalConstantVariablesTable.find(std::string(node->token.value));
+    if (global == globalConstantVariablesTable.end()) return node;
+    return ConstantNode(node, global->second);
+}
+
+spNode Optimizer::optimizeBinaryOperatorNode(const spNode& node) {
+    const spNode& left = node->leftNode;
+    const spNode& right = node->rightNode;
+    if (left->kind != NodeKind::Constant || right->kind != NodeKind::Constant) return node;
+
+    BinaryOperator op = binaryOperatorFor(node->token.kind);
+    if (op == BinaryOperator::COUNT) return node;
+    OperationSite site = { left->positionStart, left->positionEnd, right->positionStart, right->positionEnd, noContext };
+    RuntimeResult result = binaryOperation(op, left->value, right->value, site);
+    if (result.hasError()) return node;
+    return ConstantNode(node, result.value);
+}
+
+spNode Optimizer::optimizeUnaryOperatorNode(const spNode& node) {
+    const spNode& operand = node->rightNode;
+    if (operand->kind != NodeKind::Constant) return node;
+
+    UnaryOperator op = unaryOperatorFor(node->token.kind);
+    if (op == UnaryOperator::COUNT) return node;
+    OperationSite site = { operand->positionStart, operand->positionEnd, operand->positionStart, operand->positionEnd, noContext };
+    RuntimeResult result = unaryOperation(op, operand->value, site);
+    if (result.hasError()) return node;
+    return ConstantNode(node, result.value);
+}
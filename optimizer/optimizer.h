@@ -0,0 +1,30 @@
+#pragma once
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+#include <vector>
+#include "../ast/ast.h"
+
+// Runs on the tree from Parser::parse() before either engine sees it
+// Number literals are decoded once, and operators whose operands are all constants are evaluated here with
+// the same operations the engines use, anything that would fail is left alone so it fails at runtime instead
+struct Optimizer {
+    spNode optimize(const spNode& node);
+
+    // These only look at the node itself, its children were already optimized
+    spNode optimizeNode(const spNode& node);
+    spNode optimizeNumberNode(const spNode& node);
+    spNode optimizeVariableRetrievementNode(const spNode& node);
+    spNode optimizeBinaryOperatorNode(const spNode& node);
+    spNode optimizeUnaryOperatorNode(const spNode& node);
+
+private:
+    // A child slot whose node hasn't been folded yet, or one whose children have been and is next
+    struct Pending {
+        spNode* node;
+        bool childrenOptimized;
+    };
+    // Kept so its capacity carries over from one statement to the next
+    std::vector<Pending> pending;
+};
+
+#endif // !OPTIMIZER_H
@@ -0,0 +1,51 @@
+#include "parsecache.h"
+#include <functional>
+#include "../source/source.h"
+
+std::size_t ParseCache::KeyHash::operator()(const Key& key) const {
+    std::hash<std::string_view> hash;
+    return hash(key.text) * 31 + hash(key.filename);
+}
+
+ParseCache::ParseCache(const std::size_t& capacity) {
+    this->capacity = capacity;
+}
+
+ParseCache::Key ParseCache::keyOf(const int& fileId) {
+    const SourceFile& file = getSourceFile(fileId);
+    return { file.filename, file.text };
+}
+
+CachedProgram* ParseCache::find(const int& fileId) {
+    auto found = index.find(keyOf(fileId));
+    if (found == index.end()) {
+        misses++;
+        return nullptr;
+    }
+    hits++;
+    programs.splice(programs.begin(), programs, found->second);
+    return programs.front().get();
+}
+
+CachedProgram* ParseCache::insert(std::unique_ptr<CachedProgram>&& program) {
+    if (capacity == 0) return nullptr;
+    Key key = keyOf(program->fileId);
+    auto found = index.find(key);
+    if (found != index.end()) {
+        programs.erase(found->second);
+        index.erase(found);
+    }
+    while (programs.size() >= capacity) {
+        index.erase(keyOf(programs.back()->fileId));
+        programs.pop_back();
+        evictions++;
+    }
+    programs.push_front(std::move(program));
+    index[key] = programs.begin();
+    return programs.front().get();
+}
+
+void ParseCache::clear() {
+    index.clear();
+    programs.clear();
+}
@@ -0,0 +1,84 @@
+#pragma once
+#ifndef PARSECACHE_H
+#define PARSECACHE_H
+#include <list>
+#include <memory>
+#include <vector>
+#include <string_view>
+#include <unordered_map>
+#include <cstddef>
+#include "../ast/ast.h"
+#include "../arena/arena.h"
+#include "../bytecode/bytecode.h"
+#include "../source/source.h"
+
+// No SymbolTable ever has this version
+const unsigned long long unresolvedLayout = ~0ULL;
+
+// A program that was lexed, parsed and optimized once, kept so the same text only has to be evaluated next time
+struct CachedProgram {
+    // The file it was parsed from, nodes keep pointing into its text and errors show its name, so it holds a reference
+    int fileId;
+    // Every node comes from here and not from the Runner's arena, so they outlive the run that parsed them
+    // Declared first so it is destroyed after the nodes
+    Arena arena;
+    // Already optimized
+    std::vector<spNode> statements;
+    // One per statement, compiled the first time it runs on the VM and again whenever the Resolver binds it differently
+    std::vector<spChunk> chunks;
+    // One per statement, the SymbolTable::layoutVersion it was last resolved against, so it only has to be resolved
+    // again once the table changes, unresolvedLayout until it first runs
+    std::vector<unsigned long long> resolvedLayouts;
+
+    CachedProgram(const int& fileId) : arena(4 * 1024) {
+        this->fileId = fileId;
+        retainSourceFile(fileId);
+    }
+
+    ~CachedProgram() {
+        releaseSourceFile(fileId);
+    }
+
+    CachedProgram(const CachedProgram&) = delete;
+    CachedProgram& operator=(const CachedProgram&) = delete;
+};
+
+// Least recently used cache of CachedPrograms, keyed by filename and text
+// The key views the registered SourceFile, which the CachedProgram holds a reference to, so nothing is copied to make it
+struct ParseCache {
+    // 0 turns the cache off
+    std::size_t capacity;
+    std::size_t hits = 0;
+    std::size_t misses = 0;
+    std::size_t evictions = 0;
+
+    ParseCache(const std::size_t& capacity = 64);
+
+    std::size_t size() const { return programs.size(); }
+
+    // The program parsed from a file with the same name and text, nullptr on a miss
+    CachedProgram* find(const int& fileId);
+    // Takes the program and evicts the least recently used one if the cache is full
+    CachedProgram* insert(std::unique_ptr<CachedProgram>&& program);
+    void clear();
+
+private:
+    struct Key {
+        std::string_view filename;
+        std::string_view text;
+
+        bool operator==(const Key& other) const { return filename == other.filename && text == other.text; }
+    };
+
+    struct KeyHash {
+        std::size_t operator()(const Key& key) const;
+    };
+
+    // Most recently used first
+    std::list<std::unique_ptr<CachedProgram>> programs;
+    std::unordered_map<Key, std::list<std::unique_ptr<CachedProgram>>::iterator, KeyHash> index;
+
+    static Key keyOf(const int& fileId);
+};
+
+#endif // !PARSECACHE_H
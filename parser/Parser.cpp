@@ -1,206 +1,251 @@
 #include "parser.h"
 #include <vector>
 #include <memory>
-#include <functional>
+#include <array>
 #include "../token/token.h"
 #include "../token/tokens.h"
 #include "../ast/ast.h"
 #include "../reservedwords/reservedwords.h"
 
-// https://stackoverflow.com/a/20303915/12101554
-bool in_array(const std::string& value, const std::vector<std::string>& array) {
-    return std::find(array.begin(), array.end(), value) != array.end();
+// How tightly each level of syntax.txt holds on to its operands, loosest first
+namespace bindingpowers {
+    const int Compare = 10;
+    const int Expr = 20;
+    const int Term = 30;
+    // Also what a unary + or - applies to, since factor is (PLUS|MINUS) factor or an exponent
+    const int Exponent = 40;
+    // What ! applies to
+    const int Atom = 50;
+}
+
+struct InfixOperator {
+    // An operator only takes what is on its left if this is at least the binding power that was being parsed
+    int left = 0;
+    // What the right side is parsed with, one more than left makes the operator left associative
+    int right = 0;
+};
+
+// Indexed by TokenKind, tokens that aren't binary operators have a left of 0 so they never bind
+constexpr std::array<InfixOperator, (size_t) TokenKind::COUNT> makeInfixOperators() {
+    using namespace bindingpowers;
+    std::array<InfixOperator, (size_t) TokenKind::COUNT> table = {};
+    for (TokenKind kind : { TokenKind::DOUBLE_EQUAL, TokenKind::BANG_EQUAL, TokenKind::LESS_THAN, TokenKind::LESS_THAN_EQUAL, TokenKind::GREATER_THAN, TokenKind::GREATER_THAN_EQUAL }) {
+        table[(size_t) kind] = { Compare, Compare + 1 };
+    }
+    for (TokenKind kind : { TokenKind::PLUS, TokenKind::MINUS }) {
+        table[(size_t) kind] = { Expr, Expr + 1 };
+    }
+    for (TokenKind kind : { TokenKind::ASTERISK, TokenKind::F_SLASH, TokenKind::DOUBLE_F_SLASH }) {
+        table[(size_t) kind] = { Term, Term + 1 };
+    }
+    // Right associative, and the right side is a factor so it can start with a unary + or -
+    table[(size_t) TokenKind::DOUBLE_ASTERISK] = { Exponent, Exponent };
+    return table;
 }
 
-Parser::Parser(const std::vector<Token>& tokens) {
-    this->tokens = tokens;
-    this->tokenIndex = -1;
-    nextToken();
+constexpr std::array<InfixOperator, (size_t) TokenKind::COUNT> infixOperators = makeInfixOperators();
+
+Parser::Parser(const TokenList& tokens) : tokens(tokens) {
+    this->currentToken = &tokens[0];
+    this->tokenIndex = 0;
 }
 
-Token Parser::nextToken() {
-    tokenIndex++;
-    if ((unsigned) tokenIndex < tokens.size()) {
-        currentToken = tokens[tokenIndex];
+void Parser::nextToken() {
+    // The Lexer always ends the list with an EOF token, which stays current once it's reached
+    if ((unsigned) tokenIndex + 1 < tokens.size()) {
+        tokenIndex++;
+        currentToken = &tokens[tokenIndex];
     }
-    return currentToken;
 }
 
-Token Parser::peekToken(unsigned int num) const {
+TokenKind Parser::peekKind(unsigned int num) const {
     if (tokenIndex + num + 1 >= tokens.size()) {
-        return Token();
-    } else {
-        return tokens[tokenIndex + num + 1];
+        return TokenKind::UNDEFINED_TYPE;
     }
-}
+    return tokens[tokenIndex + num + 1].kind;
+}
+
+ParseResult Parser::expression(int bindingPower) {
+    using namespace bindingpowers;
+    const size_t pendingSize = pending.size();
+    spNode left = nullptr;
+
+    while (true) {
+        // Everything in front of the next atom is put aside until the atom is parsed
+        while (left == nullptr) {
+            const Token* token = currentToken;
+            // Only an expr can be an assignment, which is every operand of compare
+            if (bindingPower <= Compare + 1 && nextIsAssignment()) {
+                if (token->kind != TokenKind::IDENTIFIER)
+                    return abandon(pendingSize, ErrorRecord(ErrorKind::InvalidSyntax, MessageId::ExpectedIdentifier, token->positionStart, token->positionEnd));
+                pending.push_back({ PendingKind::Assignment, token, nullptr, bindingPower });
+                nextToken();
+                nextToken();
+                bindingPower = Compare;
+                continue;
+            }
+            switch (token->kind) {
+                case TokenKind::BANG:
+                {
+                    pending.push_back({ PendingKind::UnaryOperator, token, nullptr, bindingPower });
+                    nextToken();
+                    bindingPower = Atom;
+                    break;
+                }
+                case TokenKind::PLUS:
+                case TokenKind::MINUS:
+                {
+                    // ! only takes an atom
+                    if (bindingPower > Exponent)
+                        return abandon(pendingSize, ErrorRecord(ErrorKind::InvalidSyntax, MessageId::ExpectedAtom, token->positionStart, token->positionEnd));
+                    pending.push_back({ PendingKind::UnaryOperator, token, nullptr, bindingPower });
+                    nextToken();
+                    bindingPower = Exponent;
+                    break;
+                }
+                case TokenKind::OPEN_PAREN:
+                {
+                    pending.push_back({ PendingKind::Parenthesis, token, nullptr, bindingPower });
+                    nextToken();
+                    bindingPower = Compare;
+                    break;
+                }
+                case TokenKind::NUMBER:
+                {
+                    left = NumberNode(*token);
+                    nextToken();
+                    break;
+                }
+                case TokenKind::IDENTIFIER:
+                {
+                    left = VariableRetrievementNode(*token);
+                    nextToken();
+                    break;
+                }
+                default:
+                {
+                    return abandon(pendingSize, ErrorRecord(ErrorKind::InvalidSyntax, MessageId::ExpectedAtom, token->positionStart, token->positionEnd));
+                }
+            }
+        }
 
-ParseResult Parser::atom() {
-    ParseResult pr;
-    Token token = currentToken;
-    if (token.type == tokens::BANG) {
-        nextToken();
-        pr.registerAdvancement();
-        spNode value = pr.registerPR(atom());
-        if (pr.hasError()) return pr;
-        return pr.success(UnaryOperatorNode(token, value));
-} else if (token.type == tokens::NUMBER) {
-        nextToken();
-        pr.registerAdvancement();
-        return pr.success(NumberNode(token));
-    } else if (token.type == tokens::IDENTIFIER) {
-        nextToken();
-        pr.registerAdvancement();
-        return pr.success(VariableRetrievementNode(token));
-    } else if (token.type == tokens::OPEN_PAREN) {
-        nextToken();
-        pr.registerAdvancement();
-        spNode value = pr.registerPR(assignment());
-        if (pr.hasError()) return pr;
-        if (currentToken.type == tokens::CLOSE_PAREN) {
+        const InfixOperator& infix = infixOperators[(size_t) currentToken->kind];
+        if (infix.left != 0 && infix.left >= bindingPower) {
+            pending.push_back({ PendingKind::BinaryOperator, currentToken, std::move(left), bindingPower });
             nextToken();
-            pr.registerAdvancement();
-            return pr.success(value);
+            bindingPower = infix.right;
+            left = nullptr;
+            continue;
         }
-        return pr.failure(InvalidSyntaxError(currentToken.positionStart, currentToken.positionEnd, "Expected a ')'"));
-    } else {
-        return pr.failure(InvalidSyntaxError(currentToken.positionStart, currentToken.positionEnd, "Expected a number, identifier, '+', '-', or a '('"));
-    }
-}
-
-ParseResult Parser::exponent() {
-    std::function<ParseResult()> rule1 = [this]() { return atom(); };
-    std::function<ParseResult()> rule2 = [this]() { return factor(); };
-    return binaryOperation(rule1, { tokens::DOUBLE_ASTERISK }, rule2);
-}
-
-ParseResult Parser::factor() {
-    ParseResult pr;
-    Token token = currentToken;
-    if (in_array(token.type, { tokens::PLUS, tokens::MINUS })) {
-        nextToken();
-        pr.registerAdvancement();
-        spNode factorRes = pr.registerPR(factor());
-        if (pr.hasError()) return pr;
-        return pr.success(UnaryOperatorNode(token, factorRes));
-    }
-    return exponent();
-}
 
-ParseResult Parser::term() {
-    std::function<ParseResult()> rule = [this]() { return factor(); };
-    return binaryOperation(rule, { tokens::ASTERISK, tokens::F_SLASH, tokens::DOUBLE_F_SLASH });
-}
-
-ParseResult Parser::expr() {
-    ParseResult pr;
-    if (nextIsAssignment()) {
-        return assignment();
-    } else {
-        std::function<ParseResult()> rule = [this]() { return term(); };
-        spNode termRes = pr.registerPR(binaryOperation(rule, { tokens::PLUS, tokens::MINUS }));
-        if (pr.hasError()) {
-            return pr.failure(InvalidSyntaxError(currentToken.positionStart, currentToken.positionEnd, "Expected a number, identifier, '+', '-', or a '('"));
+        // Nothing else binds to left, so it finishes whatever was put aside last
+        if (pending.size() == pendingSize) return ParseResult().success(left);
+        PendingOperation operation = std::move(pending.back());
+        pending.pop_back();
+        bindingPower = operation.bindingPower;
+        switch (operation.kind) {
+            case PendingKind::BinaryOperator:
+            {
+                left = BinaryOperatorNode(operation.left, *operation.token, left);
+                break;
+            }
+            case PendingKind::UnaryOperator:
+            {
+                left = UnaryOperatorNode(*operation.token, left);
+                break;
+            }
+            case PendingKind::Assignment:
+            {
+                left = VariableAssignmentNode(*operation.token, left);
+                break;
+            }
+            case PendingKind::Parenthesis:
+            {
+                if (currentToken->kind != TokenKind::CLOSE_PAREN)
+                    return abandon(pendingSize, ErrorRecord(ErrorKind::InvalidSyntax, MessageId::ExpectedCloseParen, currentToken->positionStart, currentToken->positionEnd));
+                nextToken();
+                break;
+            }
         }
-        return pr.success(termRes);
     }
 }
 
-ParseResult Parser::compare(bool hasRecursed) {
-    if (hasRecursed)
-        return expr();
-    using namespace tokens;
-    std::function<ParseResult()> rule1 = [this]() { return compare(true); };
-    std::function<ParseResult()> rule2 = [this]() { return expr(); };
-    return binaryOperation(rule1, { DOUBLE_EQUAL, BANG_EQUAL, LESS_THAN, LESS_THAN_EQUAL, GREATER_THAN, GREATER_THAN_EQUAL }, rule2);
-}
-
-ParseResult Parser::assignment() {
-    ParseResult pr;
-    if (nextIsAssignment()) {
-        if (!currentToken.matches(tokens::IDENTIFIER))
-            return pr.failure(InvalidSyntaxError(currentToken.positionStart, currentToken.positionEnd, "Expected an identifier"));
-        Token variableNameToken = currentToken;
-        nextToken();
-        pr.registerAdvancement();
-        if (!currentToken.matches(tokens::EQUAL))
-            return pr.failure(InvalidSyntaxError(currentToken.positionStart, currentToken.positionEnd, "Expected an '='"));
-        nextToken();
-        pr.registerAdvancement();
-        spNode value = pr.registerPR(compare());
-        if (pr.hasError()) return pr;
-        return pr.success(VariableAssignmentNode(variableNameToken, value));
-    } else {
-        return compare();
-    }
+ParseResult Parser::abandon(const size_t& pendingSize, const ErrorRecord& error) {
+    pending.erase(pending.begin() + pendingSize, pending.end());
+    return ParseResult().failure(error);
 }
 
 ParseResult Parser::declaration() {
     ParseResult pr;
     nextToken();
-    pr.registerAdvancement();
-    Token variableNameToken = currentToken;
-    if (variableNameToken.type != tokens::IDENTIFIER)
-        return pr.failure(InvalidSyntaxError(variableNameToken.positionStart, variableNameToken.positionEnd, "Expected an identifier"));
+    const Token& variableNameToken = *currentToken;
+    if (variableNameToken.kind != TokenKind::IDENTIFIER)
+        return pr.failure(ErrorRecord(ErrorKind::InvalidSyntax, MessageId::ExpectedIdentifier, variableNameToken.positionStart, variableNameToken.positionEnd));
     spNode value = nullptr;
     nextToken();
-    pr.registerAdvancement();
-    if (currentToken.matches(tokens::EQUAL)) {
+    if (currentToken->kind == TokenKind::EQUAL) {
         nextToken();
-        pr.registerAdvancement();
-        value = pr.registerPR(assignment());
+        ParseResult valueResult = expression(bindingpowers::Compare);
+        if (valueResult.hasError()) return valueResult;
+        value = valueResult.node;
     } else {
-        value = VariableRetrievementNode(Token(tokens::IDENTIFIER, "null", variableNameToken.positionStart, variableNameToken.positionEnd, false));
+        value = VariableRetrievementNode(Token(TokenKind::IDENTIFIER, "null", variableNameToken.positionStart, variableNameToken.positionEnd, false));
     }
-    if (pr.hasError())
-        return pr;
     return pr.success(VariableDeclarationNode(variableNameToken, value));
 }
 
 ParseResult Parser::statement() {
-    if (currentToken.matches(tokens::KEYWORD, reservedWords::LET)) {
+    if (currentToken->kind == TokenKind::KEYWORD && currentToken->value == reservedWords::LET) {
         return declaration();
     } else {
-        ParseResult pr = compare();
+        const int startIndex = tokenIndex;
+        ParseResult pr = expression(bindingpowers::Compare);
         if (pr.hasError()) {
-            return pr.failure(InvalidSyntaxError(currentToken.positionStart, currentToken.positionEnd, "Expected a 'let', number, identifier, '+', '-', or a '('"));
+            // Errors after the first token say what was wrong there, otherwise nothing here starts a statement
+            if (tokenIndex != startIndex) return pr;
+            return ParseResult().failure(ErrorRecord(ErrorKind::InvalidSyntax, MessageId::ExpectedStatement, currentToken->positionStart, currentToken->positionEnd));
         }
-        if (!pr.hasError() && currentToken.type != tokens::EEOF) {
-            return pr.failure(InvalidSyntaxError(currentToken.positionStart, currentToken.positionEnd, "Expected a '+', '-', '*', '/', '**', '//', or a '('"));
+        if (!isStatementEnd()) {
+            return pr.failure(ErrorRecord(ErrorKind::InvalidSyntax, MessageId::ExpectedOperator, currentToken->positionStart, currentToken->positionEnd));
         }
         return pr;
     }
 }
 
-ParseResult Parser::parse() {
-    return statement();
+ParseResult Parser::program() {
+    ParseResult pr;
+    std::vector<spNode> statements;
+    Position positionStart = currentToken->positionStart;
+    skipStatementSeparators();
+    while (currentToken->kind != TokenKind::EEOF) {
+        ParseResult statementResult = statement();
+        if (statementResult.hasError()) return statementResult;
+        // Anything left before the separator is an error for every statement, let included
+        if (!isStatementEnd()) {
+            return pr.failure(ErrorRecord(ErrorKind::InvalidSyntax, MessageId::ExpectedOperator, currentToken->positionStart, currentToken->positionEnd));
+        }
+        statements.push_back(statementResult.node);
+        skipStatementSeparators();
+    }
+    if (!statements.empty()) positionStart = statements.front()->positionStart;
+    Position positionEnd = statements.empty() ? currentToken->positionEnd : statements.back()->positionEnd;
+    return pr.success(ProgramNode(statements, positionStart, positionEnd));
 }
 
-ParseResult Parser::binaryOperation(const std::function<ParseResult()>& rule, const std::vector<std::string>& allowedTokens) {
-    return binaryOperation(rule, allowedTokens, rule);
+ParseResult Parser::parse() {
+    return program();
 }
 
-ParseResult Parser::binaryOperation(const std::function<ParseResult()>& rule1, const std::vector<std::string>& allowedTokens, const std::function<ParseResult()>& rule2) {
-    ParseResult pr;
-    spNode left = pr.registerPR(rule1());
-    if (pr.hasError()) return pr;
+bool Parser::isStatementEnd() const {
+    return currentToken->kind == TokenKind::NEWLINE || currentToken->kind == TokenKind::SEMICOLON || currentToken->kind == TokenKind::EEOF;
+}
 
-    while (in_array(currentToken.type, allowedTokens)) {
-        Token operatorToken = currentToken;
+void Parser::skipStatementSeparators() {
+    while (currentToken->kind == TokenKind::NEWLINE || currentToken->kind == TokenKind::SEMICOLON) {
         nextToken();
-        pr.registerAdvancement();
-        spNode right = pr.registerPR(rule2());
-        if (pr.hasError()) return pr;
-        left = BinaryOperatorNode(left, operatorToken, right);
     }
-
-    return pr.success(left);
 }
 
 bool Parser::nextIsAssignment() const {
-    return peekToken(0).matches(tokens::EQUAL);
-}
-
-bool Parser::nextIsCompare() const {
-    using namespace tokens;
-    return in_array(peekToken(0).type, { DOUBLE_EQUAL, BANG_EQUAL, LESS_THAN, LESS_THAN_EQUAL, GREATER_THAN, GREATER_THAN_EQUAL });
+    return peekKind(0) == TokenKind::EQUAL;
 }
@@ -3,68 +3,75 @@
 #define PARSER_H
 #include <vector>
 #include <memory>
-#include <functional>
+#include <cstdint>
 #include "../token/token.h"
 #include "../ast/ast.h"
 #include "../error/error.h"
+#include "../arena/arena.h"
 
 struct ParseResult {
-    spError error = nullptr;
+    const ErrorRecord* error = nullptr;
     spNode node = nullptr;
-    int advancementCount = 0;
 
     bool hasError() const { return error != nullptr; }
 
-    void registerAdvancement() {
-        this->advancementCount++;
-    }
-
-    std::shared_ptr<Node> registerPR(const ParseResult& pr) {
-        this->advancementCount += pr.advancementCount;
-        if (pr.hasError()) {
-            this->error = pr.error;
-        }
-        return pr.node;
-    }
-
     ParseResult success(const spNode& node) {
         this->node = node;
-        return *this;
+        return std::move(*this);
     }
 
-    ParseResult failure(const spError& error) {
-        if (this->error == nullptr || this->advancementCount == 0)
-            this->error = error;
-        return *this;
+    ParseResult failure(const ErrorRecord& error) {
+        this->error = keepErrorRecord(error);
+        return std::move(*this);
     }
 };
 
+// A precedence climbing (Pratt) parser for the grammar in syntax.txt
+// Operators that are still waiting for their right side are kept on pending instead of on the native stack,
+// so nesting depth is only limited by memory
+// The tokens aren't copied, so the TokenList has to outlive the Parser
 struct Parser {
-    Parser(const std::vector<Token>& tokens);
+    Parser(const TokenList& tokens);
 
-    std::vector<Token> tokens;
-    Token currentToken;
+    const TokenList& tokens;
+    const Token* currentToken;
     int tokenIndex;
 
-    Token nextToken();
-    Token peekToken(unsigned int index = 0U) const;
+    void nextToken();
+    TokenKind peekKind(unsigned int index = 0U) const;
 
-    ParseResult atom();
-    ParseResult exponent();
-    ParseResult factor();
-    ParseResult term();
-    ParseResult expr();
-    ParseResult assignment();
-    ParseResult compare(bool hasRecursed = false);
+    // compare, and everything under it, for a caller that is bindingPower deep in the grammar
+    ParseResult expression(int bindingPower);
     ParseResult declaration();
     ParseResult statement();
+    ParseResult program();
     ParseResult parse();
 
-    ParseResult binaryOperation(const std::function<ParseResult()>& rule, const std::vector<std::string>& allowedTokens);
-    ParseResult binaryOperation(const std::function<ParseResult()>& rule1, const std::vector<std::string>& allowedTokens, const std::function<ParseResult()>& rule2);
-
+    bool isStatementEnd() const;
+    void skipStatementSeparators();
     bool nextIsAssignment() const;
-    bool nextIsCompare() const;
+
+private:
+    enum class PendingKind : uint8_t {
+        BinaryOperator,
+        UnaryOperator,
+        Assignment,
+        Parenthesis,
+    };
+
+    struct PendingOperation {
+        PendingKind kind;
+        // The operator, the variable name or the (
+        const Token* token;
+        // What a binary operator already has on its left
+        spNode left;
+        // What the operation itself was being parsed with, restored once it's finished
+        int bindingPower;
+    };
+
+    std::vector<PendingOperation, ArenaAllocator<PendingOperation>> pending;
+
+    ParseResult abandon(const size_t& pendingSize, const ErrorRecord& error);
 };
 
 #endif // !PARSER_H
@@ -0,0 +1,371 @@
+#include "pool.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace {
+    const std::size_t sizeClasses[] = { 16, 32, 48, 64, 96, 128, 192, 256 };
+    const int sizeClassCount = sizeof(sizeClasses) / sizeof(sizeClasses[0]);
+    // Slabs are aligned to their size, so the slab a block came from is found by masking the block's address
+    const std::size_t slabSize = 64 * 1024;
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct BlockCache;
+
+    // Sits at the start of every slab, its blocks follow it
+    struct Slab {
+        // The cache that hands out this slab's blocks, nullptr after its thread exited until another thread adopts it
+        std::atomic<BlockCache*> owner{ nullptr };
+        // Blocks given back on any other thread, the owner takes all of them at once
+        std::atomic<FreeBlock*> remoteFree{ nullptr };
+        // Everything below is only touched by the owner, or under abandonedMutex while there isn't one
+        FreeBlock* free = nullptr;
+        // What hasn't been cut into blocks yet
+        char* next = nullptr;
+        char* end = nullptr;
+        Slab* previous = nullptr;
+        Slab* following = nullptr;
+        int sizeClass = 0;
+        // Blocks handed out and not back on free yet, blocks on remoteFree still count
+        unsigned int used = 0;
+        bool full = false;
+    };
+
+    const std::size_t slabHeaderSize = (sizeof(Slab) + poolAlignment - 1) / poolAlignment * poolAlignment;
+
+    Slab* slabOf(void* block) {
+        return reinterpret_cast<Slab*>(reinterpret_cast<std::uintptr_t>(block) & ~(std::uintptr_t) (slabSize - 1));
+    }
+
+    void* mapSlab() {
+#ifdef _WIN32
+        // VirtualAlloc already hands out 64 KiB aligned regions
+        return VirtualAlloc(NULL, slabSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#else
+        // Twice the size is sure to hold an aligned slab, the rest is unmapped again
+        void* mapping = mmap(nullptr, 2 * slabSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapping == MAP_FAILED) return nullptr;
+        std::uintptr_t start = reinterpret_cast<std::uintptr_t>(mapping);
+        std::uintptr_t aligned = (start + slabSize - 1) & ~(std::uintptr_t) (slabSize - 1);
+        std::uintptr_t tail = start + 2 * slabSize - (aligned + slabSize);
+        if (aligned != start) munmap(mapping, aligned - start);
+        if (tail != 0) munmap(reinterpret_cast<void*>(aligned + slabSize), tail);
+        return reinterpret_cast<void*>(aligned);
+#endif
+    }
+
+    void unmapSlab(Slab* slab) {
+        slab->~Slab();
+#ifdef _WIN32
+        VirtualFree(slab, 0, MEM_RELEASE);
+#else
+        munmap(slab, slabSize);
+#endif
+    }
+
+    void link(Slab*& head, Slab* slab) {
+        slab->previous = nullptr;
+        slab->following = head;
+        if (head != nullptr) head->previous = slab;
+        head = slab;
+    }
+
+    void unlink(Slab*& head, Slab* slab) {
+        if (slab->previous != nullptr) slab->previous->following = slab->following;
+        else head = slab->following;
+        if (slab->following != nullptr) slab->following->previous = slab->previous;
+        slab->previous = nullptr;
+        slab->following = nullptr;
+    }
+
+    // Slabs whose thread exited while some of their blocks were still handed out
+    std::mutex abandonedMutex;
+    Slab* abandoned = nullptr;
+    std::atomic<int> abandonedCount{ 0 };
+    // What every exited thread's cache did, added up
+    PoolStats exitedStats[sizeClassCount];
+    unsigned long long exitedOversizedAllocations = 0;
+
+    thread_local BlockCache* currentCache = nullptr;
+    thread_local bool threadExited = false;
+    thread_local unsigned long long oversizedAllocations = 0;
+
+    struct SizeClassPool {
+        // Where blocks come from until it has none left
+        Slab* current = nullptr;
+        // The cache's other slabs, the ones that had no blocks left the last time they were looked at are kept apart
+        // so finding one with blocks doesn't walk them
+        Slab* available = nullptr;
+        Slab* full = nullptr;
+        PoolStats stats;
+    };
+
+    struct BlockCache {
+        SizeClassPool pools[sizeClassCount];
+        // Every cache belongs to one thread except the one threads share once their own is gone, which never goes away
+        bool owned = true;
+
+        BlockCache(const bool& owned = true) : owned(owned) {
+            if (owned) currentCache = this;
+        }
+
+        // Takes the blocks given back on other threads, returns whether there were any
+        bool collectRemote(Slab* slab) {
+            FreeBlock* block = slab->remoteFree.exchange(nullptr, std::memory_order_acquire);
+            if (block == nullptr) return false;
+            SizeClassPool& pool = pools[slab->sizeClass];
+            while (block != nullptr) {
+                FreeBlock* next = block->next;
+                block->next = slab->free;
+                slab->free = block;
+                slab->used--;
+                pool.stats.remoteFrees++;
+                block = next;
+            }
+            return true;
+        }
+
+        bool hasBlock(Slab* slab) {
+            return slab->free != nullptr || slab->next != slab->end || collectRemote(slab);
+        }
+
+        void release(Slab* slab) {
+            pools[slab->sizeClass].stats.slabsReleased++;
+            unmapSlab(slab);
+        }
+
+        Slab* cutSlab(const int& sizeClass) {
+            void* memory = mapSlab();
+            if (memory == nullptr) throw std::bad_alloc();
+            Slab* slab = new (memory) Slab();
+            slab->owner.store(this, std::memory_order_relaxed);
+            slab->sizeClass = sizeClass;
+            slab->next = static_cast<char*>(memory) + slabHeaderSize;
+            slab->end = slab->next + (slabSize - slabHeaderSize) / sizeClasses[sizeClass] * sizeClasses[sizeClass];
+            pools[sizeClass].stats.slabs++;
+            return slab;
+        }
+
+        // Takes on the abandoned slabs of this size class and unmaps any abandoned slab that is empty by now, returns
+        // one that has blocks to give
+        Slab* adopt(const int& sizeClass) {
+            if (abandonedCount.load(std::memory_order_relaxed) == 0) return nullptr;
+            std::lock_guard<std::mutex> lock(abandonedMutex);
+            Slab* found = nullptr;
+            for (Slab* slab = abandoned; slab != nullptr;) {
+                Slab* following = slab->following;
+                collectRemote(slab);
+                if (slab->used == 0) {
+                    unlink(abandoned, slab);
+                    abandonedCount--;
+                    release(slab);
+                } else if (slab->sizeClass == sizeClass) {
+                    unlink(abandoned, slab);
+                    abandonedCount--;
+                    slab->owner.store(this, std::memory_order_relaxed);
+                    bool hasBlocks = slab->free != nullptr || slab->next != slab->end;
+                    if (found == nullptr && hasBlocks) {
+                        found = slab;
+                    } else {
+                        slab->full = !hasBlocks;
+                        link(slab->full ? pools[sizeClass].full : pools[sizeClass].available, slab);
+                    }
+                }
+                slab = following;
+            }
+            return found;
+        }
+
+        // Called once current has no blocks left, makes the next slab with blocks current
+        Slab* nextSlab(const int& sizeClass) {
+            SizeClassPool& pool = pools[sizeClass];
+            if (pool.current != nullptr) {
+                pool.current->full = true;
+                link(pool.full, pool.current);
+                pool.current = nullptr;
+            }
+            while (pool.available != nullptr) {
+                Slab* slab = pool.available;
+                unlink(pool.available, slab);
+                if (hasBlock(slab)) return pool.current = slab;
+                slab->full = true;
+                link(pool.full, slab);
+            }
+            // Other threads may have given blocks back to full slabs since they were last looked at
+            Slab* found = nullptr;
+            for (Slab* slab = pool.full; slab != nullptr;) {
+                Slab* following = slab->following;
+                if (collectRemote(slab)) {
+                    unlink(pool.full, slab);
+                    slab->full = false;
+                    if (found == nullptr) found = slab;
+                    else if (slab->used == 0) release(slab);
+                    else link(pool.available, slab);
+                }
+                slab = following;
+            }
+            if (found == nullptr) found = adopt(sizeClass);
+            if (found == nullptr) found = cutSlab(sizeClass);
+            return pool.current = found;
+        }
+
+        void* allocate(const int& sizeClass) {
+            SizeClassPool& pool = pools[sizeClass];
+            pool.stats.allocations++;
+            Slab* slab = pool.current;
+            if (slab == nullptr || !hasBlock(slab)) slab = nextSlab(sizeClass);
+            slab->used++;
+            if (slab->free != nullptr) {
+                FreeBlock* block = slab->free;
+                slab->free = block->next;
+                pool.stats.reused++;
+                return block;
+            }
+            void* block = slab->next;
+            slab->next += sizeClasses[sizeClass];
+            return block;
+        }
+
+        // For a block of one of this cache's slabs, given back on its thread
+        void deallocate(Slab* slab, FreeBlock* block) {
+            SizeClassPool& pool = pools[slab->sizeClass];
+            pool.stats.frees++;
+            block->next = slab->free;
+            slab->free = block;
+            slab->used--;
+            if (slab == pool.current) return;
+            if (slab->used == 0) {
+                // Only current is kept around empty, every other slab goes back to the OS as soon as it is
+                unlink(slab->full ? pool.full : pool.available, slab);
+                release(slab);
+            } else if (slab->full) {
+                unlink(pool.full, slab);
+                slab->full = false;
+                link(pool.available, slab);
+            }
+        }
+
+        // Unmaps the slabs that are empty and leaves the rest to be adopted, blocks given back to them from now on
+        // go on their remoteFree
+        ~BlockCache() {
+            if (!owned) return;
+            currentCache = nullptr;
+            threadExited = true;
+            std::lock_guard<std::mutex> lock(abandonedMutex);
+            for (int i = 0; i < sizeClassCount; i++) {
+                SizeClassPool& pool = pools[i];
+                if (pool.current != nullptr) link(pool.available, pool.current);
+                pool.current = nullptr;
+                for (Slab** list : { &pool.available, &pool.full }) {
+                    while (*list != nullptr) {
+                        Slab* slab = *list;
+                        unlink(*list, slab);
+                        collectRemote(slab);
+                        if (slab->used == 0) {
+                            release(slab);
+                            continue;
+                        }
+                        slab->owner.store(nullptr, std::memory_order_relaxed);
+                        slab->full = false;
+                        link(abandoned, slab);
+                        abandonedCount++;
+                    }
+                }
+                PoolStats& total = exitedStats[i];
+                total.allocations += pool.stats.allocations;
+                total.reused += pool.stats.reused;
+                total.frees += pool.stats.frees;
+                total.remoteFrees += pool.stats.remoteFrees;
+                total.slabs += pool.stats.slabs;
+                total.slabsReleased += pool.stats.slabsReleased;
+            }
+            exitedOversizedAllocations += oversizedAllocations;
+        }
+    };
+
+    // Made by the thread's first pool allocation, which is also what registers its destructor to run at thread exit
+    BlockCache& threadCache() {
+        thread_local BlockCache cache;
+        return cache;
+    }
+
+    // What a thread allocates from after its own cache is gone, in the destructors of thread_locals made before it
+    std::mutex sharedCacheMutex;
+    BlockCache& sharedCache() {
+        static BlockCache* cache = new BlockCache(false);
+        return *cache;
+    }
+
+    int sizeClassFor(const std::size_t& size) {
+        for (int i = 0; i < sizeClassCount; i++) {
+            if (size <= sizeClasses[i]) return i;
+        }
+        return -1;
+    }
+}
+
+void* poolAllocate(const std::size_t& size) {
+    int sizeClass = sizeClassFor(size);
+    if (sizeClass == -1) {
+        oversizedAllocations++;
+        return ::operator new(size);
+    }
+    if (currentCache != nullptr) return currentCache->allocate(sizeClass);
+    if (!threadExited) return threadCache().allocate(sizeClass);
+    std::lock_guard<std::mutex> lock(sharedCacheMutex);
+    return sharedCache().allocate(sizeClass);
+}
+
+void poolDeallocate(void* pointer, const std::size_t& size) {
+    if (pointer == nullptr) return;
+    if (sizeClassFor(size) == -1) {
+        ::operator delete(pointer);
+        return;
+    }
+    Slab* slab = slabOf(pointer);
+    FreeBlock* block = static_cast<FreeBlock*>(pointer);
+    BlockCache* cache = currentCache;
+    if (cache != nullptr && slab->owner.load(std::memory_order_relaxed) == cache) {
+        cache->deallocate(slab, block);
+        return;
+    }
+    // Some other thread's block, it goes back to that thread the next time it runs out
+    FreeBlock* head = slab->remoteFree.load(std::memory_order_relaxed);
+    do {
+        block->next = head;
+    } while (!slab->remoteFree.compare_exchange_weak(head, block, std::memory_order_release, std::memory_order_relaxed));
+}
+
+std::vector<PoolStats> poolStats(const bool includeExitedThreads) {
+    std::vector<PoolStats> stats(sizeClassCount);
+    std::unique_lock<std::mutex> lock(abandonedMutex, std::defer_lock);
+    if (includeExitedThreads) lock.lock();
+    for (int i = 0; i < sizeClassCount; i++) {
+        if (currentCache != nullptr) stats[i] = currentCache->pools[i].stats;
+        if (includeExitedThreads) {
+            stats[i].allocations += exitedStats[i].allocations;
+            stats[i].reused += exitedStats[i].reused;
+            stats[i].frees += exitedStats[i].frees;
+            stats[i].remoteFrees += exitedStats[i].remoteFrees;
+            stats[i].slabs += exitedStats[i].slabs;
+            stats[i].slabsReleased += exitedStats[i].slabsReleased;
+        }
+        stats[i].blockSize = sizeClasses[i];
+    }
+    return stats;
+}
+
+unsigned long long poolOversizedAllocations(const bool includeExitedThreads) {
+    if (!includeExitedThreads) return oversizedAllocations;
+    std::lock_guard<std::mutex> lock(abandonedMutex);
+    return oversizedAllocations + exitedOversizedAllocations;
+}
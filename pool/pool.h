@@ -0,0 +1,70 @@
+#pragma once
+#ifndef POOL_H
+#define POOL_H
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// Blocks for the small fixed-size things that are made and dropped all the time (Contexts, SymbolTables and the
+// shared_ptr control blocks around them, a SymbolTable's name map nodes and Objects), so they don't each go to the
+// global heap
+// Every thread cuts its blocks from its own 64 KiB slabs, one size class per slab, so taking and giving back a block
+// on the thread it came from never locks
+// A block given back on another thread goes on its slab's lock-free remote list, and its own thread takes it back
+// once it runs out, so memory never drifts from one thread's pool to another's
+// A slab goes back to the OS as soon as all of its blocks are given back, except the one each size class is cutting
+// from, and the slabs of a thread that exits are taken on by the next thread that needs a slab of their size
+
+// Every block is aligned to this, anything that needs more goes to the global heap
+const std::size_t poolAlignment = 16;
+// Anything bigger than the largest size class goes to the global heap
+const std::size_t poolMaximumBlockSize = 256;
+
+void* poolAllocate(const std::size_t& size);
+void poolDeallocate(void* pointer, const std::size_t& size);
+
+// For one size class on the calling thread
+struct PoolStats {
+    std::size_t blockSize = 0;
+    // Blocks handed out, and how many of those came off the free list instead of a slab
+    unsigned long long allocations = 0;
+    unsigned long long reused = 0;
+    // Blocks given back on this thread, and blocks of this thread's slabs given back on others
+    unsigned long long frees = 0;
+    unsigned long long remoteFrees = 0;
+    // Slabs cut, and slabs given back to the OS, each slab is 64 KiB
+    unsigned long long slabs = 0;
+    unsigned long long slabsReleased = 0;
+};
+
+// For the calling thread, added to every thread that already exited with includeExitedThreads
+std::vector<PoolStats> poolStats(const bool includeExitedThreads = false);
+// Allocations that were too big or too aligned for the pool
+unsigned long long poolOversizedAllocations(const bool includeExitedThreads = false);
+
+// A standard allocator on top of the pool, for std::allocate_shared and containers
+template<class T>
+struct PoolAllocator {
+    typedef T value_type;
+
+    PoolAllocator() noexcept {}
+    template<class U> PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+    T* allocate(const std::size_t n) {
+        if (alignof(T) > poolAlignment) return static_cast<T*>(::operator new(n * sizeof(T)));
+        return static_cast<T*>(poolAllocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* pointer, const std::size_t n) noexcept {
+        if (alignof(T) > poolAlignment) {
+            ::operator delete(pointer);
+            return;
+        }
+        poolDeallocate(pointer, n * sizeof(T));
+    }
+
+    template<class U> bool operator==(const PoolAllocator<U>&) const noexcept { return true; }
+    template<class U> bool operator!=(const PoolAllocator<U>&) const noexcept { return false; }
+};
+
+#endif // !POOL_H
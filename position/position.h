@@ -2,41 +2,34 @@
 #ifndef POSITION_H
 #define POSITION_H
 #include <string>
+#include <string_view>
+#include "../source/source.h"
 
+// Small enough to copy everywhere, the filename, text, line and column all come from the SourceFile when needed
 struct Position {
+    int fileId;
     int index;
-    int lineNumber;
-    int columnNumber;
-    std::string filename;
-    std::string filetext;
 
     Position() {
+        fileId = -1;
         index = 0;
-        lineNumber = 0;
-        columnNumber = 0;
-        filename = "UNKNOWN_FILE";
-        filetext = "UNKNOWN_FILE_TEXT";
     }
 
-    Position(const int& index, const int& lineNumber, const int& columnNumber, const std::string& filename, const std::string& filetext) {
+    Position(const int& fileId, const int& index) {
+        this->fileId = fileId;
         this->index = index;
-        this->lineNumber = lineNumber;
-        this->columnNumber = columnNumber;
-        this->filename = filename;
-        this->filetext = filetext;
     }
 
-    Position advance(const char& currentChar = ' ') {
+    Position advance() {
         index++;
-        columnNumber++;
-
-        if (currentChar == '\n') {
-            lineNumber++;
-            columnNumber = 0;
-        }
-
         return *this;
     }
+
+    const SourceFile& file() const { return getSourceFile(fileId); }
+    const std::string& filename() const { return file().filename; }
+    std::string_view filetext() const { return file().text; }
+    int lineNumber() const { return file().lineNumber(index); }
+    int columnNumber() const { return file().columnNumber(index); }
 };
 
 #endif // !POSITION_H
@@ -0,0 +1,146 @@
+#include "profiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+
+std::size_t Profiler::SpanHash::operator()(const Span& span) const {
+    std::size_t hash = std::hash<int>()(span.fileId);
+    hash = hash * 31 + std::hash<int>()(span.start);
+    return hash * 31 + std::hash<int>()(span.end);
+}
+
+Profiler::Profiler() {
+    stacks.push_back({ -1, -1 });
+}
+
+Profiler::~Profiler() {
+    for (const auto& span : spans) releaseSourceFile(span.first.fileId);
+}
+
+int Profiler::labelId(const std::string& label) {
+    auto found = labelIds.find(label);
+    if (found != labelIds.end()) return found->second;
+    labels.push_back(label);
+    labelIds.emplace(label, labels.size() - 1);
+    return labels.size() - 1;
+}
+
+void Profiler::enter(const int& label, ProfileEntry* first, ProfileEntry* second) {
+    int parent = frames.empty() ? 0 : frames.back().stack;
+    auto child = stacks[parent].children.find(label);
+    int stack;
+    if (child != stacks[parent].children.end()) {
+        stack = child->second;
+    } else {
+        stack = stacks.size();
+        stacks[parent].children.emplace(label, stack);
+        stacks.push_back({ label, parent });
+    }
+    first->calls++;
+    first->active++;
+    if (second != nullptr) {
+        second->calls++;
+        second->active++;
+    }
+    frames.push_back({ stack, { first, second }, Clock::now() });
+}
+
+void Profiler::enterNode(const Node& node) {
+    scratch = node.nodeType;
+    if (node.kind != NodeKind::Number && node.kind != NodeKind::Constant) {
+        scratch += ' ';
+        scratch += node.token.value;
+    }
+    int label = labelId(scratch);
+
+    auto type = nodeTypes.find(node.nodeType);
+    if (type == nodeTypes.end()) {
+        type = nodeTypes.emplace(node.nodeType, ProfileEntry()).first;
+        type->second.label = node.nodeType;
+    }
+    auto span = spans.try_emplace(Span{ node.positionStart.fileId, node.positionStart.index, node.positionEnd.index });
+    if (span.second) retainSourceFile(node.positionStart.fileId);
+    enter(label, &type->second, &span.first->second);
+}
+
+void Profiler::enterOperation(const Token& token, const bool& unary) {
+    ProfileEntry& entry = (unary ? unaryOperations : binaryOperations)[(std::size_t) token.kind];
+    if (entry.label.empty()) entry.label = (unary ? "unary " : "binary ") + std::string(token.value);
+    enter(labelId(entry.label), &entry, nullptr);
+}
+
+void Profiler::exit() {
+    Frame frame = frames.back();
+    frames.pop_back();
+    long long elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - frame.start).count();
+    long long exclusive = elapsed - frame.children;
+    stacks[frame.stack].exclusive += exclusive;
+    for (ProfileEntry* entry : frame.entries) {
+        if (entry == nullptr) continue;
+        entry->exclusive += exclusive;
+        if (--entry->active == 0) entry->inclusive += elapsed;
+    }
+    if (!frames.empty()) frames.back().children += elapsed;
+}
+
+void Profiler::writeFolded(std::ostream& out) const {
+    // Depth first with an explicit stack of (stack index, length of path before it), deep trees don't recurse
+    std::vector<std::pair<int, std::size_t>> pending;
+    std::string path;
+    for (const auto& child : stacks[0].children) pending.push_back({ child.second, 0 });
+    while (!pending.empty()) {
+        std::pair<int, std::size_t> next = pending.back();
+        pending.pop_back();
+        const Stack& stack = stacks[next.first];
+        path.resize(next.second);
+        if (!path.empty()) path += ';';
+        path += labels[stack.label];
+        if (stack.exclusive > 0) out << path << ' ' << stack.exclusive << '\n';
+        for (const auto& child : stack.children) pending.push_back({ child.second, path.size() });
+    }
+}
+
+namespace {
+    void writeTable(std::ostream& out, const char* title, std::vector<const ProfileEntry*> entries, const std::size_t& top) {
+        std::sort(entries.begin(), entries.end(), [](const ProfileEntry* a, const ProfileEntry* b) {
+            if (a->exclusive != b->exclusive) return a->exclusive > b->exclusive;
+            return a->label < b->label;
+        });
+        std::size_t shown = std::min(top, entries.size());
+        out << title << " (top " << shown << " of " << entries.size() << " by exclusive time)\n";
+        char line[64];
+        std::snprintf(line, sizeof(line), "%12s %14s %14s  ", "calls", "inclusive ms", "exclusive ms");
+        out << line << "name\n";
+        for (std::size_t i = 0; i < shown; i++) {
+            const ProfileEntry& entry = *entries[i];
+            std::snprintf(line, sizeof(line), "%12llu %14.3f %14.3f  ", entry.calls, entry.inclusive / 1e6, entry.exclusive / 1e6);
+            out << line << entry.label << '\n';
+        }
+    }
+}
+
+void Profiler::writeSummary(std::ostream& out, const std::size_t& top) const {
+    std::vector<const ProfileEntry*> entries;
+    for (const auto& type : nodeTypes) entries.push_back(&type.second);
+    writeTable(out, "node types", entries, top);
+
+    entries.clear();
+    for (const ProfileEntry& entry : binaryOperations) if (entry.calls > 0) entries.push_back(&entry);
+    for (const ProfileEntry& entry : unaryOperations) if (entry.calls > 0) entries.push_back(&entry);
+    out << '\n';
+    writeTable(out, "operators", entries, top);
+
+    // Spans only get a label here since working out lines and columns on every call would dominate the profile
+    std::vector<ProfileEntry> labelled;
+    labelled.reserve(spans.size());
+    for (const auto& span : spans) {
+        labelled.push_back(span.second);
+        Position start(span.first.fileId, span.first.start);
+        Position end(span.first.fileId, span.first.end);
+        labelled.back().label = start.filename() + ":" + std::to_string(start.lineNumber() + 1) + ":" + std::to_string(start.columnNumber() + 1) + "-" + std::to_string(end.lineNumber() + 1) + ":" + std::to_string(end.columnNumber());
+    }
+    entries.clear();
+    for (const ProfileEntry& entry : labelled) entries.push_back(&entry);
+    out << '\n';
+    writeTable(out, "source spans", entries, top);
+}
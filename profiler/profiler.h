@@ -0,0 +1,94 @@
+#pragma once
+#ifndef PROFILER_H
+#define PROFILER_H
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../ast/ast.h"
+#include "../token/tokens.h"
+
+// Calls and time for one node type, operator or source span, times are in nanoseconds
+struct ProfileEntry {
+    std::string label;
+    unsigned long long calls = 0;
+    // Only counted by the outermost call when the same entry is on the stack more than once, so recursion isn't
+    // counted twice
+    long long inclusive = 0;
+    // Inclusive minus what the children took
+    long long exclusive = 0;
+    int active = 0;
+};
+
+// Where the Interpreter spends its time, filled in by Interpreter::visit while Interpreter::profiler is set
+// Every node and every binary_* or unary_* call is a frame, and frames are kept as a tree of call stacks so they
+// can be written out as folded stacks for flamegraph tools
+struct Profiler {
+    Profiler();
+    ~Profiler();
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    // Around every node the Interpreter visits
+    void enterNode(const Node& node);
+    // Around the binary_* or unary_* call of an operator node, after its operands were visited
+    void enterOperation(const Token& token, const bool& unary);
+    void exit();
+
+    // One "frame;frame;frame nanoseconds" line per distinct call stack, with the time spent in its last frame
+    void writeFolded(std::ostream& out) const;
+    // The top entries by exclusive time for node types, operators and source spans
+    void writeSummary(std::ostream& out, const std::size_t& top) const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Span {
+        int fileId;
+        int start;
+        int end;
+
+        bool operator==(const Span& other) const { return fileId == other.fileId && start == other.start && end == other.end; }
+    };
+
+    struct SpanHash {
+        std::size_t operator()(const Span& span) const;
+    };
+
+    // A node in the tree of call stacks, 0 is the root above every top level frame
+    struct Stack {
+        int label;
+        int parent;
+        std::unordered_map<int, int> children;
+        long long exclusive = 0;
+    };
+
+    struct Frame {
+        int stack;
+        ProfileEntry* entries[2];
+        Clock::time_point start;
+        // Inclusive time of the frames called from this one
+        long long children = 0;
+    };
+
+    std::unordered_map<std::string, int> labelIds;
+    std::vector<std::string> labels;
+    std::vector<Stack> stacks;
+    std::vector<Frame> frames;
+
+    std::unordered_map<std::string, ProfileEntry> nodeTypes;
+    std::array<ProfileEntry, (std::size_t) TokenKind::COUNT> binaryOperations;
+    std::array<ProfileEntry, (std::size_t) TokenKind::COUNT> unaryOperations;
+    // Each span holds a reference to its file, the summary shows its text
+    std::unordered_map<Span, ProfileEntry, SpanHash> spans;
+    // Reused to build labels without allocating on every call
+    std::string scratch;
+
+    int labelId(const std::string& label);
+    void enter(const int& label, ProfileEntry* first, ProfileEntry* second);
+};
+
+#endif // !PROFILER_H
@@ -0,0 +1,109 @@
+#include "program.h"
+#include "../arena/arena.h"
+#include "../context/context.h"
+#include "../source/source.h"
+#include "../lexer/lexer.h"
+#include "../parser/parser.h"
+#include "../optimizer/optimizer.h"
+#include "../resolver/resolver.h"
+#include "../compiler/compiler.h"
+#include "../vm/vm.h"
+
+ProgramResult Program::compile(const std::string& source, const std::vector<std::string>& bindingNames, const std::string& name) {
+    ProgramResult result;
+    std::shared_ptr<Program> program = std::make_shared<Program>();
+    program->names = bindingNames;
+
+    spSymbolTable layout = makeSharedSymbolTable();
+    for (unsigned int i = 0; i < bindingNames.size(); i++) {
+        if (isGlobalConstantVariable(bindingNames[i])) {
+            result.error = "Binding \"" + bindingNames[i] + "\" is a global constant variable";
+            return result;
+        }
+        if (layout->reserveSlot(bindingNames[i]) != (int) i) {
+            result.error = "Binding \"" + bindingNames[i] + "\" is given more than once";
+            return result;
+        }
+        layout->setSlot(i, Null());
+    }
+
+    // Tokens, nodes and errors are only needed until everything is compiled
+    Arena arena;
+    ArenaScope arenaScope(arena);
+
+    program->fileId = registerSourceFile(name, source);
+    Lexer lexer = Lexer(program->fileId);
+    MultiLexResult mlr = lexer.tokenize();
+    if (mlr.hasError()) {
+        result.error = mlr.error->to_string();
+        return result;
+    }
+    if (mlr.tokenized.size() != 1) {
+        Parser parser = Parser(mlr.tokenized);
+        ParseResult abSyTree = parser.parse();
+        if (abSyTree.hasError()) {
+            result.error = abSyTree.error->to_string();
+            return result;
+        }
+        Optimizer optimizer;
+        Resolver resolver;
+        Compiler compiler;
+        for (const spNode& parsed : abSyTree.node->statementNodes) {
+            spNode statement = optimizer.optimize(parsed);
+            resolver.resolve(statement, layout);
+            // A statement only runs once every statement before it succeeded, so whatever those declared can be bound
+            // to its slot, the engines still check that it was declared before reading it
+            for (unsigned int slot = 0; slot < layout->declared.size(); slot++) {
+                if (!layout->declared[slot]) layout->declareSlot(slot);
+            }
+            CompileResult compiled = compiler.compile(statement);
+            if (compiled.hasError()) {
+                result.error = compiled.error->to_string();
+                return result;
+            }
+            program->chunks.push_back(compiled.chunk);
+        }
+    }
+
+    for (unsigned int slot = bindingNames.size(); slot < layout->declared.size(); slot++) layout->declared[slot] = false;
+    layout->layoutVersion = newLayoutVersion();
+    program->layout = *layout;
+    result.program = program;
+    return result;
+}
+
+Program::~Program() {
+    releaseSourceFile(fileId);
+}
+
+EvaluationResult Program::evaluate(const std::vector<Value>& bindings) const {
+    EvaluationResult result;
+    result.value = Null();
+    if (bindings.size() != names.size()) {
+        result.success = false;
+        result.error = "Expected " + std::to_string(names.size()) + " bindings, got " + std::to_string(bindings.size());
+        return result;
+    }
+
+    spContext context = makeSharedContext("<main>");
+    context->symbolTable = makeSharedSymbolTable(layout);
+    for (unsigned int i = 0; i < bindings.size(); i++) {
+        context->symbolTable->setSlot(i, bindings[i]);
+    }
+
+    // Only runtime errors come from here, and they are rendered before the next evaluation on this thread resets it
+    thread_local Arena arena(4 * 1024);
+    arena.reset();
+    ArenaScope arenaScope(arena);
+    thread_local VM vm;
+    for (const spChunk& chunk : chunks) {
+        RuntimeResult rt = vm.run(*chunk, context);
+        if (rt.hasError()) {
+            result.success = false;
+            result.error = rt.error->to_string();
+            return result;
+        }
+        result.value = rt.value;
+    }
+    return result;
+}
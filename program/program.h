@@ -0,0 +1,65 @@
+#pragma once
+#ifndef PROGRAM_H
+#define PROGRAM_H
+#include <memory>
+#include <string>
+#include <vector>
+#include "../object/object.h"
+#include "../bytecode/bytecode.h"
+#include "../symboltable/symboltable.h"
+
+struct Program;
+
+typedef std::shared_ptr<const Program> spProgram;
+
+struct ProgramResult {
+    spProgram program = nullptr;
+    // The rendered error when the source couldn't be compiled
+    std::string error;
+
+    bool hasError() const { return program == nullptr; }
+};
+
+struct EvaluationResult {
+    // What the last statement evaluated to, null for a program with no statements
+    Value value;
+    // The rendered error when a statement failed, the statements after it don't run
+    std::string error;
+    bool success = true;
+
+    bool hasError() const { return !success; }
+};
+
+// What libbarkscript is built around: source text is lexed, parsed, optimized, resolved and compiled once by
+// Program::compile, and the Program it gives back can be evaluated any number of times, from any number of
+// threads at once, without touching the source again
+// Nothing here writes anywhere, values and errors are handed back to the caller
+struct Program {
+    // bindingNames are variables that get a value from the caller on every evaluation, they act like variables that
+    // were declared before the first statement
+    // name is what errors say the source is called, the text stays registered for as long as the Program is alive
+    static ProgramResult compile(const std::string& source, const std::vector<std::string>& bindingNames = {}, const std::string& name = "<program>");
+
+    // bindings has one value for each name given to compile, in the same order
+    EvaluationResult evaluate(const std::vector<Value>& bindings = {}) const;
+
+    const std::vector<std::string>& bindingNames() const { return names; }
+
+    // Use compile()
+    Program() {}
+    ~Program();
+    Program(const Program&) = delete;
+    Program& operator=(const Program&) = delete;
+
+private:
+    std::vector<std::string> names;
+    // The chunks' positions point into it, so the Program holds a reference
+    int fileId = -1;
+    // One per statement, the tree they were compiled from isn't kept
+    std::vector<spChunk> chunks;
+    // The slots the chunks were resolved against, with only the bindings declared, every evaluation starts from a copy
+    // that shares its slotIndices and only copies the slots
+    SymbolTable layout;
+};
+
+#endif // !PROGRAM_H
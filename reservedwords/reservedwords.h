@@ -2,6 +2,7 @@
 #ifndef RESERVEDWORDS_H
 #define RESERVEDWORDS_H
 #include <string>
+#include <string_view>
 #include <algorithm>
 
 namespace reservedWords {
@@ -14,7 +15,7 @@ const std::string reservedWordsArray[] = {
     reservedWords::LET,
 };
 
-inline bool isReservedWord(const std::string& identifier) {
+inline bool isReservedWord(const std::string_view& identifier) {
     return std::find(std::begin(reservedWordsArray), std::end(reservedWordsArray), identifier) != std::end(reservedWordsArray);
 }
 
@@ -0,0 +1,69 @@
+#include "resolver.h"
+#include <string>
+#include <vector>
+
+void Resolver::resolve(const spNode& node, const spSymbolTable& symbolTable) {
+    // Without recursing, so any tree the Parser can make can be resolved
+    // Nodes are bound in the order they run, a declaration reserves its slot only after its value was resolved
+    pending.clear();
+    pending.push_back({ &node, false });
+    while (!pending.empty()) {
+        Pending next = pending.back();
+        pending.pop_back();
+        const spNode& current = *next.node;
+        if (next.childrenResolved) {
+            if (current->kind == NodeKind::VariableDeclaration) resolveVariableDeclarationNode(current, symbolTable);
+            else resolveVariableReferenceNode(current, symbolTable);
+            continue;
+        }
+        switch (current->kind) {
+            case NodeKind::Program:
+                for (auto statement = current->statementNodes.rbegin(); statement != current->statementNodes.rend(); statement++) {
+                    pending.push_back({ &*statement, false });
+                }
+                break;
+            case NodeKind::VariableDeclaration:
+            case NodeKind::VariableAssignment:
+                pending.push_back({ &current, true });
+                pending.push_back({ &current->valueNode, false });
+                break;
+            case NodeKind::VariableRetrievement:
+                resolveVariableReferenceNode(current, symbolTable);
+                break;
+            case NodeKind::BinaryOperator:
+                pending.push_back({ &current->rightNode, false });
+                pending.push_back({ &current->leftNode, false });
+                break;
+            case NodeKind::UnaryOperator:
+                pending.push_back({ &current->rightNode, false });
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void Resolver::resolveVariableDeclarationNode(const spNode& node, const spSymbolTable& symbolTable) {
+    // The value was already resolved, it runs before the variable exists so it can't refer to the slot reserved here
+    std::string variableName = std::string(node->token.value);
+    if (isGlobalConstantVariable(variableName)) return bind(node, 0, -1);
+    bind(node, 0, symbolTable->reserveSlot(variableName));
+}
+
+void Resolver::resolveVariableReferenceNode(const spNode& node, const spSymbolTable& symbolTable) {
+    std::string variableName = std::string(node->token.value);
+    // Global constants are found before any scope, and setting one has to fail by name
+    if (isGlobalConstantVariable(variableName)) return bind(node, 0, -1);
+    int depth = 0;
+    for (SymbolTable* table = symbolTable.get(); table != nullptr; table = table->parent, depth++) {
+        int slot = table->findSlot(variableName);
+        if (slot != -1) return bind(node, depth, slot);
+    }
+    bind(node, 0, -1);
+}
+
+void Resolver::bind(const spNode& node, const int& depth, const int& slot) {
+    if (node->depth != depth || node->slot != slot) bindingChanges++;
+    node->depth = depth;
+    node->slot = slot;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#ifndef RESOLVER_H
+#define RESOLVER_H
+#include <vector>
+#include "../ast/ast.h"
+#include "../symboltable/symboltable.h"
+
+// Binds variable nodes to a (depth, slot) in the SymbolTable chain they are about to run against,
+// so the engines index into SymbolTable::slots instead of hashing the name on every access
+// Names that aren't declared yet and global constants are left with slot -1 and looked up by name at runtime
+struct Resolver {
+    // How many nodes have been bound to a different (depth, slot) than they had, a Chunk compiled from a tree
+    // can be run again as long as resolving the tree doesn't change this
+    int bindingChanges = 0;
+
+    void resolve(const spNode& node, const spSymbolTable& symbolTable);
+
+    // Only bind the node itself, whatever is under it was resolved first
+    void resolveVariableDeclarationNode(const spNode& node, const spSymbolTable& symbolTable);
+    void resolveVariableReferenceNode(const spNode& node, const spSymbolTable& symbolTable);
+    void bind(const spNode& node, const int& depth, const int& slot);
+
+private:
+    // A node to resolve, or one whose children were resolved and is bound next
+    struct Pending {
+        const spNode* node;
+        bool childrenResolved;
+    };
+    // Kept so its capacity carries over from one statement to the next
+    std::vector<Pending> pending;
+};
+
+#endif // !RESOLVER_H
@@ -0,0 +1,212 @@
+#include "runner.h"
+#include "../token/token.h"
+#include "../lexer/lexer.h"
+#include "../parser/parser.h"
+#include "../interpreter/interpreter.h"
+#include "../compiler/compiler.h"
+#include "../bscfile/bscfile.h"
+
+const char* const separator = "--------------------------\n";
+
+Runner::Runner(std::ostream& out, const spContext& context) : out(out) {
+    this->context = context;
+}
+
+bool Runner::run(const int& fileId) {
+    // Tokens, nodes and errors all come from the arena, nothing from the last run is still alive by now
+    arena.reset();
+    ArenaScope arenaScope(arena);
+    statementNumber = 0;
+
+    long long start = phaseStart();
+    bool success = runFile(fileId);
+    if (timings != nullptr) timings->record(phases::Run, Position(fileId, 0), 0, start);
+    return success;
+}
+
+bool Runner::runFile(const int& fileId) {
+    if ((parseCache.capacity > 0 || useBscFiles) && !printDebug) {
+        CachedProgram* program = parseCache.capacity > 0 ? parseCache.find(fileId) : nullptr;
+        if (program == nullptr) {
+            std::unique_ptr<CachedProgram> loaded = loadProgram(fileId);
+            if (loaded == nullptr) return false;
+            // Without a parse cache it only lives for this run
+            if (parseCache.capacity == 0) return runCachedProgram(*loaded);
+            program = parseCache.insert(std::move(loaded));
+        }
+        return runCachedProgram(*program);
+    }
+
+    Lexer lexer = Lexer(fileId);
+    long long start = phaseStart();
+    MultiLexResult mlr = lexer.tokenize();
+    if (timings != nullptr) timings->record(phases::Lex, Position(fileId, 0), 0, start, mlr.tokenized.size());
+    if (mlr.hasError()) {
+        report(mlr.error, true);
+        return false;
+    }
+    if (printDebug) {
+        out << '\n';
+        for (const Token& token : mlr.tokenized) {
+            out << token.to_string() << '\n';
+        }
+    }
+    if (mlr.tokenized.size() != 1) {
+        Parser parser = Parser(mlr.tokenized);
+        start = phaseStart();
+        ParseResult abSyTree = parser.parse();
+        if (timings != nullptr) timings->record(phases::Parse, Position(fileId, 0), 0, start, -1, abSyTree.hasError() ? -1 : countNodes(abSyTree.node));
+        if (abSyTree.hasError()) {
+            report(abSyTree.error, true);
+            return false;
+        }
+        for (const spNode& statement : abSyTree.node->statementNodes) {
+            if (!runStatement(statement)) return false;
+        }
+    }
+    if (printDebug) out << separator;
+    return true;
+}
+
+bool Runner::runStatement(const spNode& parsed) {
+    // The debug output shows the tree as it was parsed, the Chunk shows what is left after optimizing
+    if (printDebug) {
+        out << '\n';
+        out << parsed->to_string() << '\n';
+        out << '\n';
+    }
+    statementNumber++;
+    long long start = phaseStart();
+    spNode statement = optimizer.optimize(parsed);
+    if (timings != nullptr) timings->record(phases::Optimize, parsed->positionStart, statementNumber, start, -1, countNodes(statement));
+    return evaluate(statement);
+}
+
+std::unique_ptr<CachedProgram> Runner::loadProgram(const int& fileId) {
+    std::unique_ptr<CachedProgram> program = std::make_unique<CachedProgram>(fileId);
+    std::string bscPath;
+    if (useBscFiles) {
+        bscPath = bscPathFor(getSourceFile(fileId).filename);
+        ArenaScope programScope(program->arena);
+        long long start = phaseStart();
+        bool loaded = readBscFile(bscPath, fileId, program->statements);
+        if (timings != nullptr) {
+            timings->record(phases::Load, Position(fileId, 0), 0, start);
+            // Counted after the phase ended so counting isn't part of it
+            if (loaded) {
+                timings->events.back().nodes = 0;
+                for (const spNode& statement : program->statements) timings->events.back().nodes += countNodes(statement);
+            }
+        }
+        if (loaded) {
+            program->chunks.resize(program->statements.size());
+            program->resolvedLayouts.resize(program->statements.size(), unresolvedLayout);
+            return program;
+        }
+    }
+
+    // The tokens are only needed until the nodes are made, so they stay in the Runner's arena
+    Lexer lexer = Lexer(fileId);
+    long long start = phaseStart();
+    MultiLexResult mlr = lexer.tokenize();
+    if (timings != nullptr) timings->record(phases::Lex, Position(fileId, 0), 0, start, mlr.tokenized.size());
+    if (mlr.hasError()) {
+        report(mlr.error, true);
+        return nullptr;
+    }
+    if (mlr.tokenized.size() != 1) {
+        ArenaScope programScope(program->arena);
+        Parser parser = Parser(mlr.tokenized);
+        start = phaseStart();
+        ParseResult abSyTree = parser.parse();
+        if (timings != nullptr) timings->record(phases::Parse, Position(fileId, 0), 0, start, -1, abSyTree.hasError() ? -1 : countNodes(abSyTree.node));
+        if (abSyTree.hasError()) {
+            report(abSyTree.error, true);
+            return nullptr;
+        }
+        for (const spNode& statement : abSyTree.node->statementNodes) {
+            start = phaseStart();
+            program->statements.push_back(optimizer.optimize(statement));
+            if (timings != nullptr) timings->record(phases::Optimize, statement->positionStart, program->statements.size(), start, -1, countNodes(program->statements.back()));
+        }
+    }
+    // A script that can't be cached still runs, it is just parsed again next time
+    if (useBscFiles) writeBscFile(bscPath, getSourceFile(fileId), program->statements);
+    program->chunks.resize(program->statements.size());
+    program->resolvedLayouts.resize(program->statements.size(), unresolvedLayout);
+    return program;
+}
+
+bool Runner::runCachedProgram(CachedProgram& program) {
+    for (unsigned int i = 0; i < program.statements.size(); i++) {
+        statementNumber++;
+        if (!evaluate(program.statements[i], &program.chunks[i], &program.resolvedLayouts[i])) return false;
+    }
+    return true;
+}
+
+bool Runner::evaluate(const spNode& statement, spChunk* chunk, unsigned long long* resolvedLayout) {
+    // Resolved right before running, so everything earlier statements declared already has its slot
+    // A cached statement last resolved against the same layout would be bound the same way again, as long as there
+    // are no parent tables whose layout could have changed
+    int bindingChanges = resolver.bindingChanges;
+    long long start = phaseStart();
+    SymbolTable& table = *context->symbolTable;
+    if (resolvedLayout == nullptr || *resolvedLayout != table.layoutVersion || table.parent != nullptr) {
+        resolver.resolve(statement, context->symbolTable);
+        if (resolvedLayout != nullptr) *resolvedLayout = table.layoutVersion;
+        if (timings != nullptr) timings->record(phases::Resolve, statement->positionStart, statementNumber, start);
+    }
+
+    RuntimeResult rt;
+    // VM errors point at names in the chunk, so it has to outlive the report even when it isn't cached
+    spChunk compiledChunk;
+    if (useVM) {
+        compiledChunk = chunk != nullptr ? *chunk : nullptr;
+        if (compiledChunk == nullptr || resolver.bindingChanges != bindingChanges) {
+            Compiler compiler;
+            start = phaseStart();
+            CompileResult compiled = compiler.compile(statement);
+            if (timings != nullptr) timings->record(phases::Compile, statement->positionStart, statementNumber, start);
+            if (compiled.hasError()) {
+                report(compiled.error);
+                return false;
+            }
+            if (printDebug) {
+                out << compiled.chunk->to_string() << '\n';
+            }
+            compiledChunk = compiled.chunk;
+            if (chunk != nullptr) *chunk = compiledChunk;
+        }
+        start = phaseStart();
+        rt = vm.run(*compiledChunk, context);
+    } else {
+        // Statements that come from a parse cache or .bsc file keep their native code between runs
+        if (useJit && !statement->jitPrepared) {
+            start = phaseStart();
+            jitCompiler.prepare(statement);
+            if (timings != nullptr) timings->record(phases::Compile, statement->positionStart, statementNumber, start);
+        }
+        interpreter.profiler = profiler;
+        interpreter.quickeningStats = &quickeningStats;
+        start = phaseStart();
+        rt = interpreter.visit(statement, context);
+    }
+    if (timings != nullptr) timings->record(phases::Evaluate, statement->positionStart, statementNumber, start);
+    if (rt.hasError()) {
+        report(rt.error);
+        return false;
+    }
+    out << rt.value.to_string() << '\n';
+    return true;
+}
+
+void Runner::report(const ErrorRecord* error, const bool& blankLineFirst) {
+    if (lineErrors) {
+        out << error->to_line() << '\n';
+        return;
+    }
+    if (blankLineFirst) out << '\n';
+    out << error->to_string() << '\n';
+    out << separator;
+}
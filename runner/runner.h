@@ -0,0 +1,70 @@
+#pragma once
+#ifndef RUNNER_H
+#define RUNNER_H
+#include <ostream>
+#include "../ast/ast.h"
+#include "../context/context.h"
+#include "../arena/arena.h"
+#include "../vm/vm.h"
+#include "../interpreter/interpreter.h"
+#include "../optimizer/optimizer.h"
+#include "../resolver/resolver.h"
+#include "../parsecache/parsecache.h"
+#include "../profiler/profiler.h"
+#include "../timings/timings.h"
+#include "../jit/jit.h"
+
+// Takes a registered source file through the Lexer, Parser, Optimizer, Resolver and the picked engine, statement by statement
+// Shared by the REPL and by script files so both print the same thing
+struct Runner {
+    std::ostream& out;
+    spContext context;
+    bool printDebug = true;
+    bool useVM = true;
+    // Errors are printed as one file:line:column line each instead of with the source and arrows
+    bool lineErrors = false;
+    // Programs that were already parsed, a hit only evaluates, and resolves again if the SymbolTable's layout changed
+    // Not used while printDebug is on, since the debug output shows the Lexer and Parser a hit skips
+    ParseCache parseCache;
+    // Programs are read from and written to a .bsc file next to their source, the source's filename is taken as its
+    // path, so this is only for inputs that really are files
+    // Not used while printDebug is on either
+    bool useBscFiles = false;
+    // Handed to the Interpreter, so it only sees anything when useVM is off
+    Profiler* profiler = nullptr;
+    // Arithmetic and comparisons on numbers run as native code where they can, also only when useVM is off
+    bool useJit = false;
+    // Every phase of every input and statement is timed into it while set
+    Timings* timings = nullptr;
+    // How the Interpreter's operator nodes specialized themselves over every run, only counted when useVM is off
+    QuickeningStats quickeningStats;
+
+    Runner(std::ostream& out, const spContext& context);
+
+    // Returns false if lexing, parsing or any statement failed, statements after a failed one don't run
+    bool run(const int& fileId);
+    bool runStatement(const spNode& parsed);
+
+private:
+    Arena arena;
+    Optimizer optimizer;
+    Resolver resolver;
+    VM vm;
+    Interpreter interpreter;
+    JitCompiler jitCompiler;
+    // Counted from 1 in each run, for timings
+    int statementNumber = 0;
+
+    bool runFile(const int& fileId);
+    // Loads the program from its .bsc file, or lexes, parses and optimizes it (and writes the .bsc file)
+    // nullptr if that failed, the error is already printed
+    std::unique_ptr<CachedProgram> loadProgram(const int& fileId);
+    bool runCachedProgram(CachedProgram& program);
+    // Resolves and runs an optimized statement, chunk and resolvedLayout (if there are any) are the statement's in its
+    // CachedProgram and are kept between runs
+    bool evaluate(const spNode& statement, spChunk* chunk = nullptr, unsigned long long* resolvedLayout = nullptr);
+    void report(const ErrorRecord* error, const bool& blankLineFirst = false);
+    long long phaseStart() const { return timings != nullptr ? timings->now() : 0; }
+};
+
+#endif // !RUNNER_H
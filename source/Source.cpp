@@ -0,0 +1,205 @@
+#include "source.h"
+#include <atomic>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // Ids index fixed size chunks that are never moved or freed, so a lookup only has to load two pointers
+    // 2^21 chunks of 2^10 cover every id an int can hold, the directory is only touched as far as ids are handed out
+    const int chunkBits = 10;
+    const int chunkSize = 1 << chunkBits;
+    const int chunkCount = 1 << 21;
+
+    struct SourceChunk {
+        std::atomic<SourceFile*> files[chunkSize];
+
+        SourceChunk() {
+            for (std::atomic<SourceFile*>& file : files) file.store(nullptr, std::memory_order_relaxed);
+        }
+    };
+
+    std::atomic<SourceChunk*> sourceChunks[chunkCount];
+    // The lock is only for handing out and taking back ids, lookups never take it
+    std::mutex sourceFilesMutex;
+    int nextSourceId = 0;
+    // Ids of released files, given out again before any new one
+    std::vector<int> freeSourceIds;
+
+    int addSourceFile(SourceFile* file) {
+        std::lock_guard<std::mutex> lock(sourceFilesMutex);
+        int fileId;
+        if (!freeSourceIds.empty()) {
+            fileId = freeSourceIds.back();
+            freeSourceIds.pop_back();
+        } else {
+            fileId = nextSourceId++;
+        }
+        std::atomic<SourceChunk*>& chunk = sourceChunks[fileId >> chunkBits];
+        if (chunk.load(std::memory_order_relaxed) == nullptr) chunk.store(new SourceChunk(), std::memory_order_release);
+        // Published last, a thread that finds the file sees all of it
+        chunk.load(std::memory_order_relaxed)->files[fileId & (chunkSize - 1)].store(file, std::memory_order_release);
+        return fileId;
+    }
+}
+
+const SourceFile unknownSourceFile("UNKNOWN_FILE", "UNKNOWN_FILE_TEXT");
+
+SourceFile::SourceFile(const std::string& filename, std::string&& text) : storage(std::move(text)) {
+    this->filename = filename;
+    this->text = storage;
+}
+
+SourceFile::SourceFile(const std::string& filename, void* mapping, const std::size_t& mappingSize) {
+    this->filename = filename;
+    this->mapping = mapping;
+    this->mappingSize = mappingSize;
+    this->text = std::string_view(static_cast<const char*>(mapping), mappingSize);
+}
+
+SourceFile::~SourceFile() {
+    if (mapping != nullptr) unmapFile(mapping, mappingSize);
+}
+
+bool mapFile(const std::string& path, void*& mapping, std::size_t& size) {
+    mapping = nullptr;
+    size = 0;
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        return false;
+    }
+    size = (std::size_t) fileSize.QuadPart;
+    if (size > 0) {
+        HANDLE fileMapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (fileMapping != NULL) {
+            mapping = MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(fileMapping);
+        }
+    }
+    CloseHandle(file);
+#else
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) return false;
+    struct stat fileStat;
+    if (fstat(file, &fileStat) != 0) {
+        close(file);
+        return false;
+    }
+    size = fileStat.st_size;
+    if (size > 0) {
+        mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (mapping == MAP_FAILED) mapping = nullptr;
+    }
+    close(file);
+#endif
+    // Empty files can't be mapped, and there's nothing to gain from mapping them anyway
+    return size == 0 || mapping != nullptr;
+}
+
+void unmapFile(void* mapping, const std::size_t& size) {
+#ifdef _WIN32
+    UnmapViewOfFile(mapping);
+#else
+    munmap(mapping, size);
+#endif
+}
+
+int registerSourceFile(const std::string& filename, const std::string& text) {
+    return registerSourceFile(filename, std::string(text));
+}
+
+int registerSourceFile(const std::string& filename, std::string&& text) {
+    return addSourceFile(new SourceFile(filename, std::move(text)));
+}
+
+int registerMappedSourceFile(const std::string& path) {
+    void* mapping;
+    std::size_t size;
+    if (!mapFile(path, mapping, size)) return -1;
+    if (size == 0) return registerSourceFile(path, std::string());
+    return addSourceFile(new SourceFile(path, mapping, size));
+}
+
+const SourceFile& getSourceFile(const int& fileId) {
+    if (fileId < 0) return unknownSourceFile;
+    SourceChunk* chunk = sourceChunks[fileId >> chunkBits].load(std::memory_order_acquire);
+    if (chunk == nullptr) return unknownSourceFile;
+    SourceFile* file = chunk->files[fileId & (chunkSize - 1)].load(std::memory_order_acquire);
+    if (file == nullptr) return unknownSourceFile;
+    return *file;
+}
+
+void retainSourceFile(const int& fileId) {
+    const SourceFile& file = getSourceFile(fileId);
+    if (&file == &unknownSourceFile) return;
+    file.references.fetch_add(1, std::memory_order_relaxed);
+}
+
+void releaseSourceFile(const int& fileId) {
+    const SourceFile& file = getSourceFile(fileId);
+    if (&file == &unknownSourceFile) return;
+    if (file.references.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+    {
+        std::lock_guard<std::mutex> lock(sourceFilesMutex);
+        sourceChunks[fileId >> chunkBits].load(std::memory_order_relaxed)->files[fileId & (chunkSize - 1)].store(nullptr, std::memory_order_relaxed);
+        freeSourceIds.push_back(fileId);
+    }
+    delete &file;
+}
+
+void SourceFile::buildLineIndex() const {
+    lineStarts.clear();
+    lineStarts.push_back(0);
+    // memchr skips between line breaks much faster than checking every character
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+    for (const char* found = begin; (found = (const char*) std::memchr(found, '\n', end - found)) != nullptr; ) {
+        found++;
+        lineStarts.push_back(found - begin);
+    }
+}
+
+int SourceFile::lineIndexOf(const int& index) const {
+    ensureLineIndex();
+    // The last line start that is <= index
+    return std::upper_bound(lineStarts.begin(), lineStarts.end(), index) - lineStarts.begin() - 1;
+}
+
+int SourceFile::lineNumber(const int& index) const {
+    if (index < 0) return 0;
+    return lineIndexOf(index);
+}
+
+int SourceFile::columnNumber(const int& index) const {
+    if (index < 0) return index;
+    return index - lineStarts[lineIndexOf(index)];
+}
+
+int SourceFile::lineCount() const {
+    ensureLineIndex();
+    return lineStarts.size();
+}
+
+std::string_view SourceFile::lineText(const int& line) const {
+    ensureLineIndex();
+    if (line < 0 || (unsigned) line >= lineStarts.size()) return std::string_view();
+    int start = lineStarts[line];
+    int end = (unsigned) line + 1 < lineStarts.size() ? lineStarts[line + 1] - 1 : text.size();
+    if (end > start && text[end - 1] == '\r') end--;
+    return text.substr(start, end - start);
+}
@@ -0,0 +1,71 @@
+#pragma once
+#ifndef SOURCE_H
+#define SOURCE_H
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <mutex>
+#include <atomic>
+
+// Every piece of text handed to the Lexer is registered here once, Positions only keep the id
+// A SourceFile is counted like a shared_ptr, whoever keeps Positions into it past the call that made them holds a
+// reference, and once the last one is released the id is free to be given to the next registered file
+struct SourceFile {
+    std::string filename;
+    // Views either storage or a memory mapped file, Tokens view into it too
+    std::string_view text;
+
+    SourceFile(const std::string& filename, std::string&& text);
+    SourceFile(const std::string& filename, void* mapping, const std::size_t& mappingSize);
+    ~SourceFile();
+
+    // text may point into this object, so it can never be copied or moved
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+
+    int lineNumber(const int& index) const;
+    int columnNumber(const int& index) const;
+    int lineCount() const;
+    // A line's text without its line break, empty past the last line
+    std::string_view lineText(const int& line) const;
+
+private:
+    friend void retainSourceFile(const int& fileId);
+    friend void releaseSourceFile(const int& fileId);
+
+    mutable std::atomic<int> references{1};
+    std::string storage;
+    void* mapping = nullptr;
+    std::size_t mappingSize = 0;
+
+    // Index of the first character of every line, built the first time a line or column is asked for
+    // by whichever thread gets there first
+    mutable std::vector<int> lineStarts;
+    mutable std::once_flag indexed;
+
+    void buildLineIndex() const;
+    void ensureLineIndex() const { std::call_once(indexed, &SourceFile::buildLineIndex, this); }
+    int lineIndexOf(const int& index) const;
+};
+
+// All of these can be called from any thread
+// A registered file starts with one reference, which belongs to the caller
+extern int registerSourceFile(const std::string& filename, const std::string& text);
+extern int registerSourceFile(const std::string& filename, std::string&& text);
+// Maps the file into memory instead of reading it, returns -1 if it can't be opened
+extern int registerMappedSourceFile(const std::string& path);
+// Only for ids the caller holds a reference to, anything else is the unknown file
+// Never takes a lock, it is called for every line and column an error or a trace shows
+extern const SourceFile& getSourceFile(const int& fileId);
+// Both ignore ids that aren't registered, so a Position that was never set can be passed as is
+extern void retainSourceFile(const int& fileId);
+// Frees the file and unmaps it once no references are left
+extern void releaseSourceFile(const int& fileId);
+
+// Maps a whole file read only, false if it can't be opened or mapped
+// An empty file succeeds with a nullptr mapping and a size of 0, anything else has to be given to unmapFile
+extern bool mapFile(const std::string& path, void*& mapping, std::size_t& size);
+extern void unmapFile(void* mapping, const std::size_t& size);
+
+#endif // !SOURCE_H
@@ -1,9 +1,10 @@
 #include "symboltable.h"
 #include <unordered_map>
 #include <string>
+#include <atomic>
 #include "../object/object.h"
 
-std::unordered_map<std::string, spObject> globalConstantVariablesTable = {
+extern const std::unordered_map<std::string, Value> globalConstantVariablesTable = {
     { "null", Null() },
     { "Infinity", Number("Infinity") },
     { "NaN", Number("NaN") },
@@ -11,15 +12,28 @@ std::unordered_map<std::string, spObject> globalConstantVariablesTable = {
     { "false", Boolean(false) },
 };
 
+namespace {
+    // Each thread counts up in its own range, so tables on different threads never get the same version and the
+    // counter is only shared once per thread
+    std::atomic<unsigned long long> layoutVersionRanges{ 1 };
+    thread_local unsigned long long lastLayoutVersion = layoutVersionRanges.fetch_add(1) << 40;
+}
+
+unsigned long long newLayoutVersion() {
+    return ++lastLayoutVersion;
+}
+
 bool isGlobalConstantVariable(const std::string& identifier) {
     return globalConstantVariablesTable.find(identifier) != globalConstantVariablesTable.end();
 }
 
-spObject SymbolTable::get(const std::string& key) const {
-    if (isGlobalConstantVariable(key)) {
-        return globalConstantVariablesTable.at(key);
+const Value* SymbolTable::get(const std::string& key) const {
+    auto global = globalConstantVariablesTable.find(key);
+    if (global != globalConstantVariablesTable.end()) {
+        return &global->second;
     }
-    if (symbols.find(key) == symbols.end()) {
+    int slot = findSlot(key);
+    if (slot == -1) {
         // Key not found
         if (parent != nullptr) {
             return parent->get(key);
@@ -28,21 +42,22 @@ spObject SymbolTable::get(const std::string& key) const {
             return nullptr;
         }
     } else {
-        return symbols.at(key);
+        return &slots[slot];
     }
 }
 
-SymbolTableSetReturnCode SymbolTable::set(const std::string& key, const spObject& value, const bool forceCurrentContext) {
+SymbolTableSetReturnCode SymbolTable::set(const std::string& key, const Value& value, const bool forceCurrentContext) {
     // Returning `false` signifies that there was an error
     if (isGlobalConstantVariable(key)) {
         return SymbolTableSetReturnCode::errorGlobalConstantVariable;
     }
     if (forceCurrentContext) {
-        symbols[key] = value;
+        setSlot(reserveSlot(key), value);
         return SymbolTableSetReturnCode::perfect;
     } else {
-        if (symbols.find(key) != symbols.end()) {
-            symbols[key] = value;
+        int slot = findSlot(key);
+        if (slot != -1) {
+            setSlot(slot, value);
             return SymbolTableSetReturnCode::perfect;
         } else if (parent != nullptr) {
             return parent->set(key, value, false);
@@ -54,11 +69,47 @@ SymbolTableSetReturnCode SymbolTable::set(const std::string& key, const spObject
 }
 
 bool SymbolTable::exists(const std::string& key, const bool deepSearch) const {
-    if (symbols.find(key) != symbols.end()) {
+    if (findSlot(key) != -1) {
         return true;
     } else if (deepSearch && parent != nullptr) {
         return parent->exists(key, deepSearch);
     } else {
         return false;
     }
+}
+
+int SymbolTable::findSlot(const std::string& key) const {
+    if (slotIndices == nullptr) return -1;
+    auto index = slotIndices->find(key);
+    if (index == slotIndices->end() || !declared[index->second]) return -1;
+    return index->second;
+}
+
+int SymbolTable::reserveSlot(const std::string& key) {
+    if (slotIndices != nullptr) {
+        auto index = slotIndices->find(key);
+        if (index != slotIndices->end()) return index->second;
+    }
+    // Another table may still be looking at these indices, so it gets its own before adding to them
+    if (slotIndices == nullptr) {
+        slotIndices = std::allocate_shared<SlotIndices>(PoolAllocator<SlotIndices>());
+    } else if (slotIndices.use_count() > 1) {
+        slotIndices = std::allocate_shared<SlotIndices>(PoolAllocator<SlotIndices>(), *slotIndices);
+    }
+    slots.push_back(Null());
+    declared.push_back(false);
+    (*slotIndices)[key] = slots.size() - 1;
+    layoutVersion = newLayoutVersion();
+    return slots.size() - 1;
+}
+
+void SymbolTable::declareSlot(const int& slot) {
+    declared[slot] = true;
+    layoutVersion = newLayoutVersion();
+}
+
+SymbolTable* SymbolTable::ancestor(const int& depth) {
+    SymbolTable* table = this;
+    for (int i = 0; i < depth; i++) table = table->parent;
+    return table;
 }
\ No newline at end of file
@@ -4,6 +4,9 @@
 #include <unordered_map>
 #include <memory>
 #include <string>
+#include <vector>
+#include "../object/object.h"
+#include "../pool/pool.h"
 
 enum class SymbolTableSetReturnCode {
     perfect,
@@ -12,27 +15,61 @@ enum class SymbolTableSetReturnCode {
     errorNotInScope,
 };
 
-struct Object;
-
-typedef std::shared_ptr<Object> spObject;
-
 struct SymbolTable;
 
 typedef std::shared_ptr<SymbolTable> spSymbolTable;
 
-extern std::unordered_map<std::string, spObject> globalConstantVariablesTable;
+// Never changes after startup, so every thread can read it without locking
+extern const std::unordered_map<std::string, Value> globalConstantVariablesTable;
 
 extern bool isGlobalConstantVariable(const std::string& identifier);
 
+// A number no table on any thread has had as its layoutVersion yet
+extern unsigned long long newLayoutVersion();
+
 struct SymbolTable {
-    std::unordered_map<std::string, spObject> symbols;
-    spSymbolTable parent = nullptr;
+    typedef std::unordered_map<std::string, int, std::hash<std::string>, std::equal_to<std::string>, PoolAllocator<std::pair<const std::string, int>>> SlotIndices;
 
-    spObject get(const std::string& key) const;
-    SymbolTableSetReturnCode set(const std::string& key, const spObject& value, const bool forceCurrentContext = false);
+    // Each variable keeps the slot it was first given, so the Resolver can hand out slot indices and the engines
+    // never hash the name, slotIndices is only used for lookups by name
+    // A copy of a table shares its slotIndices until either of them reserves a new slot, so copying a Program's
+    // layout for every evaluation only copies the slots, nullptr until the first slot is reserved
+    // All of these come from the block pool, the map's nodes are all the same size and a script's few variables
+    // fit in a block
+    std::shared_ptr<SlotIndices> slotIndices;
+    std::vector<Value, PoolAllocator<Value>> slots;
+    // A slot can be reserved by the Resolver before its declaration has run
+    std::vector<bool, PoolAllocator<bool>> declared;
+    // Not owned, the enclosing scope's table outlives this one the same way a parent Context does
+    SymbolTable* parent = nullptr;
+    // Changes whenever a slot is reserved or declared for the first time, which is everything the Resolver looks at, so
+    // two tables with the same version resolve a tree the same way
+    // Every empty table is 0 and a copy keeps the version of the table it was copied from
+    unsigned long long layoutVersion = 0;
+
+    const Value* get(const std::string& key) const;
+    SymbolTableSetReturnCode set(const std::string& key, const Value& value, const bool forceCurrentContext = false);
 
     bool exists(const std::string& key, const bool deepSearch = true) const;
+
+    // Returns -1 if key isn't declared in this table
+    int findSlot(const std::string& key) const;
+    int reserveSlot(const std::string& key);
+    // Returns nullptr if the slot hasn't been declared yet
+    const Value* getSlot(const int& slot) const { return declared[slot] ? &slots[slot] : nullptr; }
+    void setSlot(const int& slot, const Value& value) {
+        slots[slot] = value;
+        if (!declared[slot]) declareSlot(slot);
+    }
+    void declareSlot(const int& slot);
+
+    // The table depth parents up, 0 is this table
+    SymbolTable* ancestor(const int& depth);
 };
 
+// The SymbolTable and its control block come from the thread's block pool, a layout is copied with its slots
+inline spSymbolTable makeSharedSymbolTable(const SymbolTable& layout = SymbolTable()) {
+    return std::allocate_shared<SymbolTable>(PoolAllocator<SymbolTable>(), layout);
+}
 
 #endif // !SYMBOLTABLE_H
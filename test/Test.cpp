@@ -0,0 +1,258 @@
+// Differential checks for the paths that are only there to be faster than another one
+// Everything is generated here and run in process, every check prints what it found and the process exits
+// with 1 if any of them failed
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <random>
+#include <vector>
+#include "../source/source.h"
+#include "../lexer/lexer.h"
+#include "../parser/parser.h"
+#include "../interpreter/interpreter.h"
+#include "../arena/arena.h"
+#include "../context/context.h"
+#include "../runner/runner.h"
+#include "../jit/jit.h"
+
+// Counts the cases where the fast path and the one it stands in for disagree, the first one is shown in full
+struct Differential {
+    std::string name;
+    int cases = 0;
+    int mismatches = 0;
+
+    Differential(const std::string& name) : name(name) {}
+
+    void compare(const std::string_view& input, const std::string& expected, const std::string& actual) {
+        cases++;
+        if (expected == actual) return;
+        if (mismatches == 0) std::cerr << name << " mismatch on:\n" << input << "\nexpected:\n" << expected << "\nactual:\n" << actual << std::endl;
+        mismatches++;
+    }
+
+    bool passed() const {
+        std::cout << name << ": " << cases << " cases, " << mismatches << " mismatches" << std::endl;
+        return cases > 0 && mismatches == 0;
+    }
+};
+
+// Random expressions over variables that hold every kind of value, nested up to depth operators deep
+std::string randomExpression(std::mt19937& random, const int& depth) {
+    const char* const leaves[] = { "x", "y", "z", "w", "0", "1", "2.5", "3", "(10 ** 308)", "0.001" };
+    const char* const binaryOperators[] = { "+", "-", "*", "/", "**", "//", "==", "!=", "<", "<=", ">", ">=" };
+    const char* const unaryOperators[] = { "-", "+", "!" };
+    int pick = depth <= 0 ? 0 : random() % 6;
+    if (pick == 0) return leaves[random() % 10];
+    if (pick == 1) return std::string(unaryOperators[random() % 3]) + "(" + randomExpression(random, depth - 1) + ")";
+    return "(" + randomExpression(random, depth - 1) + " " + binaryOperators[random() % 12] + " " + randomExpression(random, depth - 1) + ")";
+}
+
+spNode parseStatement(const int& fileId) {
+    Lexer lexer = Lexer(fileId);
+    MultiLexResult mlr = lexer.tokenize();
+    if (mlr.hasError()) return nullptr;
+    Parser parser = Parser(mlr.tokenized);
+    ParseResult pr = parser.parse();
+    if (pr.hasError() || pr.node->statementNodes.size() != 1) return nullptr;
+    return pr.node->statementNodes[0];
+}
+
+std::string describe(const RuntimeResult& rt) {
+    return rt.hasError() ? rt.error->to_line() : rt.value.to_string();
+}
+
+// Runs a whole script on a fresh Runner, with errors on one line each so they compare exactly
+template<class Configure>
+std::string runScript(const int& fileId, Configure configure) {
+    std::ostringstream out;
+    spContext context = makeSharedContext("<test>");
+    context->symbolTable = makeSharedSymbolTable();
+    Runner runner(out, context);
+    runner.printDebug = false;
+    runner.lineErrors = true;
+    runner.parseCache.capacity = 0;
+    configure(runner);
+    runner.run(fileId);
+    return out.str();
+}
+
+// The tree-walking Interpreter with and without native code, as whole scripts so the Optimizer's constants and the
+// Resolver's slots are in it too
+bool testJit() {
+    if (!jitSupported()) {
+        std::cout << "jit: skipped, no native code on this platform" << std::endl;
+        return true;
+    }
+    const char* const values[] = { "0", "-0", "3", "-2.5", "0.1", "1e308", "-1e308", "1e-310", "1 < 2", "1 > 2", "10 ** 400", "-(10 ** 400)", "(0 - 1) ** 0.5", "0 / 1" };
+    Differential differential("jit");
+    std::mt19937 random(20);
+    for (int i = 0; i < 2000; i++) {
+        std::string script;
+        for (const char* name : { "x", "y", "z" }) {
+            script += std::string("let ") + name + " = " + values[random() % 14] + "\n";
+        }
+        // w is null
+        script += "let w\n";
+        script += randomExpression(random, 4) + "\n";
+        int caseId = registerSourceFile("<test:jit case>", std::move(script));
+        std::string interpreted = runScript(caseId, [](Runner& runner) { runner.useVM = false; });
+        std::string native = runScript(caseId, [](Runner& runner) { runner.useVM = false; runner.useJit = true; });
+        differential.compare(getSourceFile(caseId).text, interpreted, native);
+        releaseSourceFile(caseId);
+    }
+    return differential.passed();
+}
+
+// The same nodes evaluated over and over as their operands change type under them, so they keep specializing and
+// deoptimizing, against nodes parsed fresh for every evaluation that never specialize
+bool testQuickening() {
+    const Value values[] = { Number(0.0), Number(-0.0), Number(3.0), Number(-2.5), Number(0.1), Number(1e308), Number(-1e308), Number("Infinity"), Number("Infinity", -0), Number("NaN"), Boolean(true), Boolean(false), Null() };
+    const int valueCount = sizeof(values) / sizeof(values[0]);
+    const int rounds = 16;
+    Differential differential("quickening");
+    QuickeningStats stats;
+    std::mt19937 random(21);
+    Arena arena;
+    for (int i = 0; i < 500; i++) {
+        int caseId = registerSourceFile("<test:quickening case>", randomExpression(random, 4));
+        spContext context = makeSharedContext("<test>");
+        context->symbolTable = makeSharedSymbolTable();
+        for (const char* name : { "x", "y", "z", "w" }) context->symbolTable->set(name, Number(1.0), true);
+        {
+            ArenaScope arenaScope(arena);
+            spNode warmed = parseStatement(caseId);
+            Interpreter interpreter;
+            interpreter.quickeningStats = &stats;
+            for (int round = 0; round < rounds; round++) {
+                // Mostly the same types as last round, so nodes get to specialize before a change deoptimizes them
+                if (round % 4 == 0) {
+                    for (const char* name : { "x", "y", "z" }) context->symbolTable->set(name, values[random() % valueCount]);
+                } else {
+                    context->symbolTable->set("x", Number((double) (random() % 7) - 3.0));
+                }
+                std::string quickened = describe(interpreter.visit(warmed, context));
+                std::string generic = describe(Interpreter().visit(parseStatement(caseId), context));
+                differential.compare(getSourceFile(caseId).text, generic, quickened);
+            }
+        }
+        arena.reset();
+        releaseSourceFile(caseId);
+    }
+    // A run where nothing specialized or nothing was ever hit wouldn't have tested anything
+    std::cout << "quickening: " << stats.specializations << " specializations, " << stats.hits << " hits, " << stats.misses << " misses, " << stats.generic << " generic" << std::endl;
+    return differential.passed() && stats.specializations > 0 && stats.hits > 0;
+}
+
+// Lines run one at a time on one Runner the way the REPL runs them, with the parse cache against without it, so lines
+// that come back from the cache and skip the Resolver have to be bound the same way as lines resolved every time
+// Every session runs twice, on a fresh SymbolTable the second time the way batch runs reuse a Runner, with its lines
+// in another order so the variables get other slots
+bool testCachedResolution() {
+    const char* const lines[] = { "let x = 1", "let y = x + 1", "x = x + 1", "y = y * x", "x + y", "z", "let z = y - x", "z = -z", "x < y", "let w = null" };
+    Differential differential("cached resolution");
+    std::mt19937 random(22);
+    for (int i = 0; i < 300; i++) {
+        std::string session;
+        std::vector<int> lineIds[2];
+        for (std::vector<int>& ids : lineIds) {
+            for (int line = 0; line < 30; line++) {
+                const char* text = lines[random() % 10];
+                session += std::string(text) + "\n";
+                ids.push_back(registerSourceFile("<test:line>", text));
+            }
+            session += "--\n";
+        }
+        for (const bool useVM : { true, false }) {
+            std::string outputs[2];
+            for (int cached = 0; cached < 2; cached++) {
+                std::ostringstream out;
+                spContext context = makeSharedContext("<test>");
+                Runner runner(out, context);
+                runner.printDebug = false;
+                runner.lineErrors = true;
+                runner.useVM = useVM;
+                if (cached == 0) runner.parseCache.capacity = 0;
+                for (const std::vector<int>& ids : lineIds) {
+                    context->symbolTable = makeSharedSymbolTable();
+                    for (const int& lineId : ids) runner.run(lineId);
+                }
+                outputs[cached] = out.str();
+            }
+            differential.compare(session, outputs[0], outputs[1]);
+        }
+        for (const std::vector<int>& ids : lineIds) {
+            for (const int& lineId : ids) releaseSourceFile(lineId);
+        }
+    }
+    return differential.passed();
+}
+
+// Reads this process's resident set size from /proc, 0 where there isn't one
+unsigned long long residentKilobytes() {
+    std::FILE* status = std::fopen("/proc/self/status", "r");
+    if (status == nullptr) return 0;
+    char line[256];
+    unsigned long long kilobytes = 0;
+    while (std::fgets(line, sizeof(line), status) != nullptr) {
+        if (std::strncmp(line, "VmRSS:", 6) == 0) {
+            kilobytes = std::strtoull(line + 6, nullptr, 10);
+            break;
+        }
+    }
+    std::fclose(status);
+    return kilobytes;
+}
+
+// A million Contexts, each with its own SymbolTable under the same parent, made, run and dropped the way call frames
+// will be, every one of them has to be gone once dropped and the resident set can't keep growing
+bool testContextChurn() {
+    const int contexts = 1000000;
+    const int warmup = 10000;
+    spContext global = makeSharedContext("<test>");
+    global->symbolTable = makeSharedSymbolTable();
+    global->symbolTable->set("x", Number(2.0), true);
+    Arena arena;
+    ArenaScope arenaScope(arena);
+    int fileId = registerSourceFile("<test:context churn>", "x * y + 1");
+    spNode statement = parseStatement(fileId);
+
+    Interpreter interpreter;
+    int leaked = 0;
+    int wrong = 0;
+    unsigned long long residentAfterWarmup = 0;
+    for (int i = 0; i < contexts; i++) {
+        if (i == warmup) residentAfterWarmup = residentKilobytes();
+        std::weak_ptr<Context> droppedContext;
+        std::weak_ptr<SymbolTable> droppedTable;
+        {
+            spContext frame = makeSharedContext("<frame>", global.get());
+            frame->symbolTable = makeSharedSymbolTable();
+            frame->symbolTable->parent = global->symbolTable.get();
+            frame->symbolTable->set("y", Number((double) i), true);
+            RuntimeResult rt = interpreter.visit(statement, frame);
+            if (rt.hasError() || rt.value.doubleValue != 2.0 * i + 1) wrong++;
+            droppedContext = frame;
+            droppedTable = frame->symbolTable;
+        }
+        if (!droppedContext.expired() || !droppedTable.expired()) leaked++;
+    }
+    long long growth = (long long) residentKilobytes() - (long long) residentAfterWarmup;
+
+    std::cout << "context churn: " << contexts << " contexts, " << leaked << " still alive, " << wrong << " wrong results, the resident set grew by " << growth << " KiB" << std::endl;
+    // Anything past a MiB would be a leak, a million Contexts leaking even one block each is far more
+    return leaked == 0 && wrong == 0 && growth <= 1024;
+}
+
+int main() {
+    bool passed = true;
+    // Every check runs even after one fails
+    passed = testJit() && passed;
+    passed = testQuickening() && passed;
+    passed = testCachedResolution() && passed;
+    passed = testContextChurn() && passed;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,85 @@
+#include "threadpool.h"
+
+ThreadPool::ThreadPool(const unsigned int& workerCount) {
+    unsigned int count = workerCount == 0 ? 1 : workerCount;
+    for (unsigned int i = 0; i < count; i++) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (unsigned int i = 0; i < count; i++) {
+        threads.emplace_back([this, i]() { work(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::submit(Task&& task) {
+    Queue& queue = *queues[nextQueue];
+    nextQueue = (nextQueue + 1) % queues.size();
+    unfinished++;
+    // Counted first so a worker that takes it right away never brings queued below 0
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        queued++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    workAvailable.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(stateMutex);
+    allFinished.wait(lock, [this]() { return unfinished == 0; });
+}
+
+bool ThreadPool::take(const unsigned int& worker, Task& task) {
+    {
+        Queue& own = *queues[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.front());
+            own.tasks.pop_front();
+            queued--;
+            return true;
+        }
+    }
+    for (unsigned int i = 1; i < queues.size(); i++) {
+        Queue& victim = *queues[(worker + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+            queued--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::work(const unsigned int& worker) {
+    while (true) {
+        Task task;
+        if (take(worker, task)) {
+            task(worker);
+            if (--unfinished == 0) {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                allFinished.notify_all();
+            }
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(stateMutex);
+        workAvailable.wait(lock, [this]() { return stopping || queued > 0; });
+        if (stopping && queued == 0) return;
+    }
+}
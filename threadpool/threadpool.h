@@ -0,0 +1,57 @@
+#pragma once
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads, each with its own queue of tasks
+// Workers take from the front of their own queue and, once it's empty, steal from the back of the others',
+// so a worker that drew a few long tasks doesn't hold everything else up
+struct ThreadPool {
+    // Tasks are told which worker runs them, so they can use state that belongs to that worker
+    typedef std::function<void(const unsigned int& worker)> Task;
+
+    ThreadPool(const unsigned int& workerCount);
+    // Finishes every task that was submitted before joining the workers
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned int workerCount() const { return threads.size(); }
+
+    // Tasks are spread over the queues round robin
+    void submit(Task&& task);
+    // Returns once every submitted task has finished
+    void wait();
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+    unsigned int nextQueue = 0;
+
+    // Workers with nothing to take sleep on workAvailable, queued is only raised while holding stateMutex
+    // so none of them can miss a submit
+    std::mutex stateMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable allFinished;
+    std::atomic<std::size_t> queued{ 0 };
+    std::atomic<std::size_t> unfinished{ 0 };
+    bool stopping = false;
+
+    void work(const unsigned int& worker);
+    bool take(const unsigned int& worker, Task& task);
+};
+
+#endif // !THREADPOOL_H
@@ -0,0 +1,120 @@
+#include "timings.h"
+#include <cstdio>
+#include <string>
+
+Timings::Timings(const Clock::time_point& origin, const unsigned int& thread) {
+    this->origin = origin;
+    this->thread = thread;
+}
+
+void Timings::record(const char* phase, const Position& position, const int& statement, const long long& start, const long long& tokens, const long long& nodes) {
+    events.push_back({ phase, position, statement, start, now() - start, tokens, nodes });
+    retainSourceFile(position.fileId);
+}
+
+Timings::~Timings() {
+    for (const TimingEvent& event : events) releaseSourceFile(event.position.fileId);
+}
+
+namespace {
+    std::string milliseconds(const long long& nanoseconds) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.3f ms", nanoseconds / 1e6);
+        return buffer;
+    }
+
+    std::string microseconds(const long long& nanoseconds) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.3f", nanoseconds / 1e3);
+        return buffer;
+    }
+
+    void writeJsonString(std::ostream& out, const std::string& text) {
+        out << '"';
+        for (const char& c : text) {
+            switch (c) {
+                case '"': out << "\\\""; break;
+                case '\\': out << "\\\\"; break;
+                case '\n': out << "\\n"; break;
+                case '\r': out << "\\r"; break;
+                case '\t': out << "\\t"; break;
+                default:
+                {
+                    if ((unsigned char) c < 0x20) {
+                        char escaped[8];
+                        std::snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char) c);
+                        out << escaped;
+                    } else {
+                        out << c;
+                    }
+                }
+            }
+        }
+        out << '"';
+    }
+}
+
+void Timings::writeBreakdown(std::ostream& out, const std::size_t& first) const {
+    // Events are recorded as phases end, so an input's run comes after everything in it, and with the parse cache
+    // every statement is optimized before the first one is resolved
+    // Lines are collected per statement and written out once the input's run is reached
+    std::vector<std::string> lines;
+    for (std::size_t i = first; i < events.size(); i++) {
+        const TimingEvent& event = events[i];
+        if (event.phase == phases::Run) {
+            out << event.position.filename() << ": run " << milliseconds(event.duration) << '\n';
+            for (const std::string& line : lines) {
+                if (!line.empty()) out << line << '\n';
+            }
+            lines.clear();
+            continue;
+        }
+        if ((std::size_t) event.statement >= lines.size()) lines.resize(event.statement + 1);
+        std::string& line = lines[event.statement];
+        if (line.empty()) {
+            line = event.statement == 0 ? "  input:" : "  statement " + std::to_string(event.statement) + " (line " + std::to_string(event.position.lineNumber() + 1) + "):";
+        } else {
+            line += ',';
+        }
+        line += std::string(" ") + event.phase + " " + milliseconds(event.duration);
+        if (event.tokens >= 0) line += " (" + std::to_string(event.tokens) + " tokens)";
+        if (event.nodes >= 0) line += " (" + std::to_string(event.nodes) + " nodes)";
+    }
+}
+
+void writeChromeTrace(std::ostream& out, const std::vector<const Timings*>& timings) {
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool firstEvent = true;
+    for (const Timings* threadTimings : timings) {
+        if (!firstEvent) out << ',';
+        firstEvent = false;
+        out << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << threadTimings->thread << ",\"args\":{\"name\":\"runner " << threadTimings->thread << "\"}}";
+        for (const TimingEvent& event : threadTimings->events) {
+            out << ",\n{\"name\":\"" << event.phase << "\",\"cat\":\"" << (event.statement == 0 ? "input" : "statement") << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << threadTimings->thread;
+            out << ",\"ts\":" << microseconds(event.start) << ",\"dur\":" << microseconds(event.duration) << ",\"args\":{\"file\":";
+            writeJsonString(out, event.position.filename());
+            out << ",\"line\":" << event.position.lineNumber() + 1;
+            if (event.statement != 0) out << ",\"statement\":" << event.statement;
+            if (event.tokens >= 0) out << ",\"tokens\":" << event.tokens;
+            if (event.nodes >= 0) out << ",\"nodes\":" << event.nodes;
+            out << "}}";
+        }
+    }
+    out << "\n]}\n";
+}
+
+long long countNodes(const spNode& node) {
+    long long count = 0;
+    std::vector<const Node*> pending;
+    if (node != nullptr) pending.push_back(node.get());
+    while (!pending.empty()) {
+        const Node* next = pending.back();
+        pending.pop_back();
+        count++;
+        for (const spNode* child : { &next->leftNode, &next->rightNode, &next->valueNode }) {
+            if (*child != nullptr) pending.push_back(child->get());
+        }
+        for (const spNode& statement : next->statementNodes) pending.push_back(statement.get());
+    }
+    return count;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#ifndef TIMINGS_H
+#define TIMINGS_H
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <vector>
+#include "../ast/ast.h"
+#include "../position/position.h"
+
+namespace phases {
+    // The whole of Runner::run for one input
+    const char* const Run = "run";
+    // Reading a .bsc file instead of lexing and parsing
+    const char* const Load = "load";
+    const char* const Lex = "lex";
+    const char* const Parse = "parse";
+    const char* const Optimize = "optimize";
+    const char* const Resolve = "resolve";
+    const char* const Compile = "compile";
+    const char* const Evaluate = "evaluate";
+};
+
+// One phase of one input, or of one statement in it
+struct TimingEvent {
+    // One of the phases:: names
+    const char* phase;
+    // Where the input or statement starts
+    Position position;
+    // Counted from 1, 0 for phases that cover the whole input
+    int statement;
+    // Nanoseconds since Timings::origin
+    long long start;
+    long long duration;
+    // -1 when they don't apply to the phase
+    long long tokens;
+    long long nodes;
+};
+
+// Filled in by a Runner while Runner::timings is set, every phase is timed with a monotonic clock
+struct Timings {
+    typedef std::chrono::steady_clock Clock;
+
+    // Runners on different threads can share an origin so their events line up in one trace
+    Clock::time_point origin;
+    // The trace's tid for these events
+    unsigned int thread;
+    // Every event holds a reference to its file, the breakdown and the trace show its name and lines
+    std::vector<TimingEvent> events;
+
+    Timings(const Clock::time_point& origin = Clock::now(), const unsigned int& thread = 0);
+    ~Timings();
+    Timings(const Timings&) = delete;
+    Timings& operator=(const Timings&) = delete;
+
+    long long now() const { return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - origin).count(); }
+    // Ends a phase that began at start (from now())
+    void record(const char* phase, const Position& position, const int& statement, const long long& start, const long long& tokens = -1, const long long& nodes = -1);
+
+    // One line per input and one per statement, for the events from index first on
+    void writeBreakdown(std::ostream& out, const std::size_t& first = 0) const;
+};
+
+// Every event as a complete ("X") event in the Chrome trace event format, for chrome://tracing or Perfetto
+// Token and node counts, the file, the line and the statement number are the events' args
+void writeChromeTrace(std::ostream& out, const std::vector<const Timings*>& timings);
+
+// How many nodes are in a tree, without recursing so any tree the Parser can make can be counted
+long long countNodes(const spNode& node);
+
+#endif // !TIMINGS_H
@@ -2,22 +2,31 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 #include <string>
+#include <string_view>
+#include <vector>
 #include "tokens.h"
 #include "../position/position.h"
+#include "../arena/arena.h"
 
 struct Token {
-    std::string type;
-    std::string value;
+    // type views one of the tokens:: constants and value views the registered source text (or a literal),
+    // so a Token never owns memory and can live in an Arena
+    std::string_view type;
+    std::string_view value;
     Position positionStart;
     Position positionEnd;
+    // The same thing as type, for code that switches on it
+    TokenKind kind;
 
     Token() {
-        type = "UNDEFINED_TYPE";
+        kind = TokenKind::UNDEFINED_TYPE;
+        type = tokens::UNDEFINED_TYPE;
         value = "NULL";
     }
 
-    Token(const std::string& type, const std::string& value, const Position positionStart, const Position positionEnd, const bool& advanceEnd = true) {
-        this->type = type;
+    Token(const TokenKind& kind, const std::string_view& value, const Position positionStart, const Position positionEnd, const bool& advanceEnd = true) {
+        this->kind = kind;
+        this->type = tokenTypeName(kind);
         this->value = value;
         this->positionStart = positionStart;
         this->positionEnd = positionEnd;
@@ -25,17 +34,19 @@ struct Token {
             this->positionEnd.advance();
     }
 
-    std::string to_string() {
-        return "Token(" + type + ", \"" + value + "\", " + std::to_string(positionStart.index) + ", " + std::to_string(positionEnd.index) + ")";
+    std::string to_string() const {
+        return "Token(" + std::string(type) + ", \"" + std::string(value) + "\", " + std::to_string(positionStart.index) + ", " + std::to_string(positionEnd.index) + ")";
     }
 
-    bool matches(std::string tokenType) {
+    bool matches(const std::string_view& tokenType) const {
         return this->type == tokenType;
     }
 
-    bool matches(std::string tokenType, std::string value) {
+    bool matches(const std::string_view& tokenType, const std::string_view& value) const {
         return this->type == tokenType && this->value == value;
     }
 };
 
+typedef std::vector<Token, ArenaAllocator<Token>> TokenList;
+
 #endif // !TOKEN_H
@@ -3,6 +3,7 @@
 #define TOKENS_H
 
 #include <string>
+#include <cstdint>
 
 namespace tokens {
     using namespace std;
@@ -37,8 +38,69 @@ namespace tokens {
     const string NUMBER = "NUMBER";
 
     // Control
+    const string NEWLINE = "NEWLINE"; // \n
+    const string SEMICOLON = "SEMICOLON"; // ;
     const string EEOF = "EOF"; // \0
     const string UNKNOWN = "UNKNOWN";
+    const string UNDEFINED_TYPE = "UNDEFINED_TYPE";
+}
+
+// One per tokens:: constant, in the same order, so the Parser can switch and index tables instead of comparing strings
+enum class TokenKind : uint8_t {
+    PLUS,
+    MINUS,
+    ASTERISK,
+    F_SLASH,
+    DOUBLE_ASTERISK,
+    DOUBLE_F_SLASH,
+    OPEN_PAREN,
+    CLOSE_PAREN,
+    BANG,
+    DOUBLE_EQUAL,
+    BANG_EQUAL,
+    LESS_THAN,
+    LESS_THAN_EQUAL,
+    GREATER_THAN,
+    GREATER_THAN_EQUAL,
+    KEYWORD,
+    IDENTIFIER,
+    EQUAL,
+    NUMBER,
+    NEWLINE,
+    SEMICOLON,
+    EEOF,
+    UNKNOWN,
+    UNDEFINED_TYPE,
+    COUNT,
+};
+
+inline const std::string& tokenTypeName(const TokenKind& kind) {
+    switch (kind) {
+        case TokenKind::PLUS: return tokens::PLUS;
+        case TokenKind::MINUS: return tokens::MINUS;
+        case TokenKind::ASTERISK: return tokens::ASTERISK;
+        case TokenKind::F_SLASH: return tokens::F_SLASH;
+        case TokenKind::DOUBLE_ASTERISK: return tokens::DOUBLE_ASTERISK;
+        case TokenKind::DOUBLE_F_SLASH: return tokens::DOUBLE_F_SLASH;
+        case TokenKind::OPEN_PAREN: return tokens::OPEN_PAREN;
+        case TokenKind::CLOSE_PAREN: return tokens::CLOSE_PAREN;
+        case TokenKind::BANG: return tokens::BANG;
+        case TokenKind::DOUBLE_EQUAL: return tokens::DOUBLE_EQUAL;
+        case TokenKind::BANG_EQUAL: return tokens::BANG_EQUAL;
+        case TokenKind::LESS_THAN: return tokens::LESS_THAN;
+        case TokenKind::LESS_THAN_EQUAL: return tokens::LESS_THAN_EQUAL;
+        case TokenKind::GREATER_THAN: return tokens::GREATER_THAN;
+        case TokenKind::GREATER_THAN_EQUAL: return tokens::GREATER_THAN_EQUAL;
+        case TokenKind::KEYWORD: return tokens::KEYWORD;
+        case TokenKind::IDENTIFIER: return tokens::IDENTIFIER;
+        case TokenKind::EQUAL: return tokens::EQUAL;
+        case TokenKind::NUMBER: return tokens::NUMBER;
+        case TokenKind::NEWLINE: return tokens::NEWLINE;
+        case TokenKind::SEMICOLON: return tokens::SEMICOLON;
+        case TokenKind::EEOF: return tokens::EEOF;
+        case TokenKind::UNKNOWN: return tokens::UNKNOWN;
+        default: return tokens::UNDEFINED_TYPE;
+    }
 }
 
 #endif // !TOKENS_H
@@ -0,0 +1,133 @@
+#include "vm.h"
+#include <string>
+#include "../object/object.h"
+#include "../object/operations.h"
+#include "../symboltable/symboltable.h"
+
+RuntimeResult setFailure(const SymbolTableSetReturnCode& code, const std::string& variableName, const InstructionSpan& span, const spContext& context) {
+    RuntimeResult rt;
+    switch (code) {
+        case SymbolTableSetReturnCode::errorGlobalConstantVariable: { return rt.failure(ErrorRecord(ErrorKind::Runtime, MessageId::ModifyGlobalConstant, span.positionStart, span.positionEnd, context.get())); }
+        case SymbolTableSetReturnCode::errorUserDefinedConstantVariable: { return rt.failure(ErrorRecord(ErrorKind::Runtime, MessageId::ModifyConstant, span.positionStart, span.positionEnd, context.get())); }
+        case SymbolTableSetReturnCode::errorNotInScope: { return rt.failure(ErrorRecord(ErrorKind::Runtime, MessageId::VariableNotInScope, span.positionStart, span.positionEnd, context.get()).with(variableName)); }
+        default: { return rt.failure(ErrorRecord(ErrorKind::Runtime, MessageId::UnknownSetReturnCode, span.positionStart, span.positionEnd, context.get()).withNumber((int) code)); }
+    }
+}
+
+RuntimeResult VM::run(const Chunk& chunk, const spContext& context) {
+    RuntimeResult rt;
+    stack.clear();
+    stack.reserve(chunk.maxStackSize);
+
+    const Instruction* code = chunk.code.data();
+    for (int ip = 0; ; ip++) {
+        const Instruction& instruction = code[ip];
+        switch (instruction.op) {
+            case OpCode::PUSH_CONSTANT:
+            {
+                stack.push_back(chunk.constants[instruction.operand]);
+                break;
+            }
+            case OpCode::LOAD_VARIABLE:
+            {
+                const std::string& variableName = chunk.names[instruction.operand];
+                const InstructionSpan& span = chunk.spans[ip];
+                const Value* value = context->symbolTable->get(variableName);
+                if (value == nullptr)
+                    return rt.failure(ErrorRecord(ErrorKind::Runtime, MessageId::VariableNotDefined, span.positionStart, span.positionEnd, context.get()).with(variableName));
+                stack.push_back(*value);
+                break;
+            }
+            case OpCode::CHECK_UNDECLARED:
+            {
+                const std::string& variableName = chunk.names[instruction.operand];
+                const InstructionSpan& span = chunk.spans[ip];
+                if (context->symbolTable->exists(variableName, false))
+                    return rt.failure(ErrorRecord(ErrorKind::Runtime, MessageId::VariableAlreadyDeclared, span.positionStart, span.positionEnd, context.get()).with(variableName));
+                break;
+            }
+            case OpCode::DECLARE_VARIABLE:
+            case OpCode::ASSIGN_VARIABLE:
+            {
+                const std::string& variableName = chunk.names[instruction.operand];
+                SymbolTableSetReturnCode success = context->symbolTable->set(variableName, stack.back(), instruction.op == OpCode::DECLARE_VARIABLE);
+                if (success != SymbolTableSetReturnCode::perfect)
+                    return setFailure(success, variableName, chunk.spans[ip], context);
+                break;
+            }
+            case OpCode::LOAD_SLOT:
+            {
+                const SlotReference& reference = chunk.slots[instruction.operand];
+                const Value* value = context->symbolTable->ancestor(reference.depth)->getSlot(reference.slot);
+                if (value == nullptr) {
+                    const InstructionSpan& span = chunk.spans[ip];
+                    return rt.failure(ErrorRecord(ErrorKind::Runtime, MessageId::VariableNotDefined, span.positionStart, span.positionEnd, context.get()).with(chunk.names[reference.name]));
+                }
+                stack.push_back(*value);
+                break;
+            }
+            case OpCode::CHECK_UNDECLARED_SLOT:
+            {
+                const SlotReference& reference = chunk.slots[instruction.operand];
+                if (context->symbolTable->ancestor(reference.depth)->getSlot(reference.slot) != nullptr) {
+                    const InstructionSpan& span = chunk.spans[ip];
+                    return rt.failure(ErrorRecord(ErrorKind::Runtime, MessageId::VariableAlreadyDeclared, span.positionStart, span.positionEnd, context.get()).with(chunk.names[reference.name]));
+                }
+                break;
+            }
+            case OpCode::DECLARE_SLOT:
+            case OpCode::ASSIGN_SLOT:
+            {
+                // The Resolver never binds global constants, so a slot can always be set
+                const SlotReference& reference = chunk.slots[instruction.operand];
+                context->symbolTable->ancestor(reference.depth)->setSlot(reference.slot, stack.back());
+                break;
+            }
+            case OpCode::BINARY_PLUS:
+            case OpCode::BINARY_MINUS:
+            case OpCode::BINARY_ASTERISK:
+            case OpCode::BINARY_F_SLASH:
+            case OpCode::BINARY_DOUBLE_ASTERISK:
+            case OpCode::BINARY_DOUBLE_F_SLASH:
+            case OpCode::BINARY_DOUBLE_EQUAL:
+            case OpCode::BINARY_BANG_EQUAL:
+            case OpCode::BINARY_LESS_THAN:
+            case OpCode::BINARY_LESS_THAN_EQUAL:
+            case OpCode::BINARY_GREATER_THAN:
+            case OpCode::BINARY_GREATER_THAN_EQUAL:
+            {
+                const InstructionSpan& span = chunk.spans[ip];
+                OperationSite site = { span.leftStart, span.leftEnd, span.rightStart, span.rightEnd, context };
+                Value& left = stack[stack.size() - 2];
+                // The BINARY_ OpCodes are in the same order as the BinaryOperators
+                BinaryOperator op = (BinaryOperator) ((int) instruction.op - (int) OpCode::BINARY_PLUS);
+                RuntimeResult result = binaryOperation(op, left, stack.back(), site);
+                if (result.hasError()) return rt.failure(result.error);
+                stack.pop_back();
+                stack.back() = result.value;
+                break;
+            }
+            case OpCode::UNARY_PLUS:
+            case OpCode::UNARY_MINUS:
+            case OpCode::UNARY_BANG:
+            {
+                const InstructionSpan& span = chunk.spans[ip];
+                OperationSite site = { span.leftStart, span.leftEnd, span.rightStart, span.rightEnd, context };
+                UnaryOperator op = (UnaryOperator) ((int) instruction.op - (int) OpCode::UNARY_PLUS);
+                RuntimeResult result = unaryOperation(op, stack.back(), site);
+                if (result.hasError()) return rt.failure(result.error);
+                stack.back() = result.value;
+                break;
+            }
+            case OpCode::RETURN:
+            {
+                return rt.success(stack.back());
+            }
+            default:
+            {
+                const InstructionSpan& span = chunk.spans[ip];
+                return rt.failure(ErrorRecord(ErrorKind::Runtime, MessageId::OpcodeNotSetUp, span.positionStart, span.positionEnd, context.get()).withNumber((int) instruction.op));
+            }
+        }
+    }
+}
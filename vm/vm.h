@@ -0,0 +1,17 @@
+#pragma once
+#ifndef VM_H
+#define VM_H
+#include <vector>
+#include <memory>
+#include "../bytecode/bytecode.h"
+#include "../context/context.h"
+#include "../interpreter/interpreter.h"
+
+// Stack machine that runs a Chunk from the Compiler, it has to give the same results and errors as the Interpreter
+struct VM {
+    std::vector<Value> stack;
+
+    RuntimeResult run(const Chunk& chunk, const spContext& context);
+};
+
+#endif // !VM_H